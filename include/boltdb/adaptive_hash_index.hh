@@ -0,0 +1,151 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "boltdb/hash.hh"
+#include "boltdb/page.hh"
+#include "boltdb/type.hh"
+
+namespace boltdb {
+
+/// Options for AdaptiveHashIndex.
+struct AdaptiveHashIndexOptions {
+  /// Number of cached positions, rounded up to a power of two.
+  std::size_t capacity = 1 << 16;
+  /// Descents to the same position before the key is served from the index.
+  std::uint32_t promote_after = 3;
+};
+
+/// \brief AdaptiveHashIndex remembers where hot keys live so a Get can go
+///        straight to the leaf instead of descending from the root.
+///
+/// Like InnoDB's adaptive hash index, entries are built from observed
+/// lookups: each descent that finds a key reports its (leaf page, element
+/// index) and, once the same position has been seen `promote_after` times,
+/// Get() serves the key with a single page touch.
+///
+/// Pages are immutable within a transaction but may be freed and reused
+/// after it, so every entry carries the txid it was observed under and is
+/// only trusted by readers of that same txid. The key stored at the slot is
+/// compared before the value is returned; any mismatch falls back to the
+/// normal descent. The index is shared by all readers of a DB.
+class AdaptiveHashIndex {
+ public:
+  explicit AdaptiveHashIndex(AdaptiveHashIndexOptions options = {})
+      : promote_after_(options.promote_after),
+        entries_(std::bit_ceil(std::max<std::size_t>(options.capacity, 1))) {}
+
+  AdaptiveHashIndex(const AdaptiveHashIndex&) = delete;
+  AdaptiveHashIndex& operator=(const AdaptiveHashIndex&) = delete;
+
+  /// Returns the value of `key` if its leaf position is cached for `txid`
+  /// and still holds the key. Returns nothing if the caller must descend.
+  [[nodiscard]] std::optional<std::span<const std::byte>> Get(
+      std::span<const std::byte> key, TransactionID txid,
+      const PageResolver& resolve) {
+    const auto hash = HashBytes(key);
+    const auto slot = SlotFor(hash);
+
+    Entry entry;
+    {
+      std::lock_guard lock(Shard(slot));
+      entry = entries_[slot];
+    }
+
+    if (entry.hash != hash || entry.txid != txid ||
+        entry.hits < promote_after_) {
+      misses_.fetch_add(1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+
+    const Page* p = resolve(entry.pgid);
+    if (p == nullptr || !p->IsLeaf() || entry.index >= p->count) {
+      misses_.fetch_add(1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+
+    const auto& elem = p->GetLeafElement(entry.index);
+    if (elem.flags != LeafFlag::kNone || CompareKeys(elem.Key(), key) != 0) {
+      misses_.fetch_add(1, std::memory_order_relaxed);
+      return std::nullopt;
+    }
+
+    hits_.fetch_add(1, std::memory_order_relaxed);
+
+    return elem.Value();
+  }
+
+  /// Reports that a descent under `txid` found `key` at element `index` of
+  /// leaf `pgid`.
+  void Record(std::span<const std::byte> key, TransactionID txid, PageId pgid,
+              std::uint16_t index) {
+    const auto hash = HashBytes(key);
+    const auto slot = SlotFor(hash);
+
+    std::lock_guard lock(Shard(slot));
+    auto& entry = entries_[slot];
+
+    if (entry.hash == hash && entry.pgid == pgid && entry.index == index) {
+      // Same position under another txid: the leaf was not rewritten in
+      // between, so the key keeps its earned hits.
+      if (entry.hits < promote_after_) ++entry.hits;
+      entry.txid = std::max(entry.txid, txid);
+      return;
+    }
+
+    entry = Entry{hash, txid, pgid, index, 1};
+  }
+
+  /// Drops every entry, e.g. after a write transaction remapped the file.
+  void Clear() {
+    for (std::size_t s = 0; s < kShards; ++s) {
+      std::lock_guard lock(shards_[s]);
+      for (std::size_t i = s; i < entries_.size(); i += kShards) {
+        entries_[i] = Entry{};
+      }
+    }
+  }
+
+  [[nodiscard]] std::uint64_t Hits() const noexcept {
+    return hits_.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::uint64_t Misses() const noexcept {
+    return misses_.load(std::memory_order_relaxed);
+  }
+
+ private:
+  static constexpr std::size_t kShards = 16;
+
+  struct Entry {
+    std::uint64_t hash = 0;
+    TransactionID txid = 0;
+    PageId pgid{};
+    std::uint16_t index = 0;
+    std::uint32_t hits = 0;
+  };
+
+  [[nodiscard]] std::size_t SlotFor(std::uint64_t hash) const noexcept {
+    return static_cast<std::size_t>(hash & (entries_.size() - 1));
+  }
+
+  std::mutex& Shard(std::size_t slot) { return shards_[slot % kShards]; }
+
+  const std::uint32_t promote_after_;
+  std::vector<Entry> entries_;
+  std::array<std::mutex, kShards> shards_;
+  std::atomic<std::uint64_t> hits_{0};
+  std::atomic<std::uint64_t> misses_{0};
+};
+
+}  // namespace boltdb
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+
+#include "boltdb/errors.hh"
+
+namespace boltdb {
+
+/// \brief AesGcm is AES-128/256 in Galois/Counter Mode (NIST SP 800-38D)
+///        with a 16-byte tag.
+///
+/// Unlike the rest of boltdb this is not implemented here: a hand-rolled
+/// AES needs table lookups or secret-dependent branches unless it is
+/// bitsliced, and either leaks the key through the cache or branch timing.
+/// OpenSSL's EVP interface is used instead. It picks AES-NI, VAES and
+/// PCLMULQDQ at runtime where the CPU has them, and falls back to
+/// constant-time vector or bitsliced code elsewhere.
+///
+/// The key is kept, and wiped when the AesGcm is destroyed; each call sets
+/// up its own cipher context, so one AesGcm may be used from many threads.
+class AesGcm {
+ public:
+  static constexpr std::size_t kTagSize = 16;
+  using Tag = std::array<std::byte, kTagSize>;
+
+  /// `key` must be 16 or 32 bytes; throws kInvalidKey otherwise.
+  explicit AesGcm(std::span<const std::byte> key) : size_(key.size()) {
+    if (size_ != 16 && size_ != 32) ThrowError(Errc::kInvalidKey);
+    std::copy(key.begin(), key.end(), key_.begin());
+  }
+
+  AesGcm(const AesGcm&) = delete;
+  AesGcm& operator=(const AesGcm&) = delete;
+
+  ~AesGcm() { OPENSSL_cleanse(key_.data(), key_.size()); }
+
+  /// Encrypts `data` in place and returns the tag over `aad` and the
+  /// ciphertext. `iv` must never repeat under one key; 12 bytes is the
+  /// fast path, any other length is hashed.
+  Tag Seal(std::span<const std::byte> iv, std::span<const std::byte> aad,
+           std::span<std::byte> data) const {
+    const auto ctx = Init(iv, aad, /*encrypt=*/true);
+    Update(ctx.get(), data);
+
+    int n = 0;
+    Tag tag;
+    if (EVP_EncryptFinal_ex(ctx.get(), nullptr, &n) != 1 ||
+        EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_GET_TAG, kTagSize,
+                            tag.data()) != 1) {
+      ThrowError(Errc::kCipherFailed);
+    }
+
+    return tag;
+  }
+
+  /// Checks `tag` and decrypts `data` in place. Returns false, leaving the
+  /// ciphertext untouched, if the tag does not match.
+  [[nodiscard]] bool Open(std::span<const std::byte> iv,
+                          std::span<const std::byte> aad,
+                          std::span<std::byte> data, const Tag& tag) const {
+    const auto ctx = Init(iv, aad, /*encrypt=*/false);
+    Update(ctx.get(), data);
+
+    int n = 0;
+    auto expected = tag;
+    if (EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_TAG, kTagSize,
+                            expected.data()) != 1) {
+      ThrowError(Errc::kCipherFailed);
+    }
+    if (EVP_DecryptFinal_ex(ctx.get(), nullptr, &n) == 1) return true;
+
+    // The tag is only known to be wrong once the data is decrypted. CTR
+    // mode is its own inverse, so encrypting again restores the ciphertext.
+    const auto undo = Init(iv, {}, /*encrypt=*/true);
+    Update(undo.get(), data);
+
+    return false;
+  }
+
+ private:
+  struct ContextDelete {
+    void operator()(EVP_CIPHER_CTX* ctx) const noexcept {
+      EVP_CIPHER_CTX_free(ctx);
+    }
+  };
+  using Context = std::unique_ptr<EVP_CIPHER_CTX, ContextDelete>;
+
+  static int Length(std::size_t n) {
+    if (n > INT_MAX) ThrowError(Errc::kCipherFailed);
+
+    return static_cast<int>(n);
+  }
+
+  static const unsigned char* Bytes(std::span<const std::byte> b) noexcept {
+    return reinterpret_cast<const unsigned char*>(b.data());
+  }
+
+  /// A context keyed for `iv` that has taken in `aad`.
+  [[nodiscard]] Context Init(std::span<const std::byte> iv,
+                             std::span<const std::byte> aad,
+                             bool encrypt) const {
+    Context ctx(EVP_CIPHER_CTX_new());
+    if (!ctx) throw std::bad_alloc();
+
+    const EVP_CIPHER* cipher = size_ == 16 ? EVP_aes_128_gcm()
+                                           : EVP_aes_256_gcm();
+    const auto* key = reinterpret_cast<const unsigned char*>(key_.data());
+    int n = 0;
+    if (EVP_CipherInit_ex(ctx.get(), cipher, nullptr, nullptr, nullptr,
+                          encrypt ? 1 : 0) != 1 ||
+        EVP_CIPHER_CTX_ctrl(ctx.get(), EVP_CTRL_GCM_SET_IVLEN,
+                            Length(iv.size()), nullptr) != 1 ||
+        EVP_CipherInit_ex(ctx.get(), nullptr, nullptr, key, Bytes(iv), -1) !=
+            1 ||
+        (!aad.empty() && EVP_CipherUpdate(ctx.get(), nullptr, &n, Bytes(aad),
+                                          Length(aad.size())) != 1)) {
+      ThrowError(Errc::kCipherFailed);
+    }
+
+    return ctx;
+  }
+
+  /// Runs `data` through the cipher in place.
+  static void Update(EVP_CIPHER_CTX* ctx, std::span<std::byte> data) {
+    if (data.empty()) return;
+
+    auto* p = reinterpret_cast<unsigned char*>(data.data());
+    int n = 0;
+    if (EVP_CipherUpdate(ctx, p, &n, p, Length(data.size())) != 1) {
+      ThrowError(Errc::kCipherFailed);
+    }
+    assert(static_cast<std::size_t>(n) == data.size());
+  }
+
+  std::array<std::byte, 32> key_{};
+  std::size_t size_;
+};
+
+}  // namespace boltdb
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <cassert>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "boltdb/buffer_pool.hh"
+#include "boltdb/eytzinger.hh"
+#include "boltdb/page.hh"
+#include "boltdb/search.hh"
+
+namespace boltdb {
+
+// ====================================================================
+// Task
+// ====================================================================
+
+/// \brief Task is a lazily started coroutine producing a T.
+///
+/// Awaiting a task starts it and resumes the awaiter when it finishes.
+/// A top-level task is started with Start() and driven by an IoLoop;
+/// its result is read with Result() once Done().
+template <typename T>
+class Task {
+ public:
+  struct promise_type {
+    Task get_return_object() {
+      return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+    }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+
+    auto final_suspend() noexcept {
+      struct Final {
+        bool await_ready() noexcept { return false; }
+        std::coroutine_handle<> await_suspend(
+            std::coroutine_handle<promise_type> h) noexcept {
+          const auto next = h.promise().continuation;
+          return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+      };
+      return Final{};
+    }
+
+    template <typename U>
+    void return_value(U&& value) {
+      result.emplace(std::forward<U>(value));
+    }
+
+    void unhandled_exception() { error = std::current_exception(); }
+
+    std::optional<T> result;
+    std::exception_ptr error;
+    std::coroutine_handle<> continuation;
+  };
+
+  Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+  Task& operator=(Task&& other) noexcept {
+    if (this != &other) {
+      if (handle_) handle_.destroy();
+      handle_ = std::exchange(other.handle_, {});
+    }
+    return *this;
+  }
+  Task(const Task&) = delete;
+  Task& operator=(const Task&) = delete;
+  ~Task() {
+    if (handle_) handle_.destroy();
+  }
+
+  /// Runs the task until its first suspension.
+  void Start() { handle_.resume(); }
+
+  [[nodiscard]] bool Done() const { return handle_.done(); }
+
+  /// The task's result; rethrows its exception. Requires Done().
+  T& Result() {
+    assert(Done());
+    auto& promise = handle_.promise();
+    if (promise.error) std::rethrow_exception(promise.error);
+
+    return *promise.result;
+  }
+
+  bool await_ready() const noexcept { return false; }
+
+  std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiter) {
+    handle_.promise().continuation = awaiter;
+    return handle_;
+  }
+
+  T await_resume() { return std::move(Result()); }
+
+ private:
+  explicit Task(std::coroutine_handle<promise_type> handle)
+      : handle_(handle) {}
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+// ====================================================================
+// I/O loop
+// ====================================================================
+
+/// \brief IoLoop runs page reads off the calling thread and resumes the
+///        coroutines waiting on them back on it.
+///
+/// Reads are blocking preads on `threads` I/O threads, so up to that many
+/// are in flight at once; the coroutines themselves only ever run on the
+/// thread calling Poll() or Run(), one lookup per suspended frame.
+class IoLoop {
+ public:
+  explicit IoLoop(std::size_t threads = 64) {
+    assert(threads > 0);
+    for (std::size_t i = 0; i < threads; ++i) {
+      workers_.emplace_back([this](std::stop_token st) { Work(st); });
+    }
+  }
+
+  IoLoop(const IoLoop&) = delete;
+  IoLoop& operator=(const IoLoop&) = delete;
+
+  ~IoLoop() {
+    for (auto& w : workers_) w.request_stop();
+    submitted_cv_.notify_all();
+  }
+
+  /// Runs `io` on an I/O thread, then resumes `waiter` from Poll(). Called
+  /// from the loop thread.
+  void Submit(std::function<void()> io, std::coroutine_handle<> waiter) {
+    ++in_flight_;
+    {
+      std::lock_guard lock(mu_);
+      submitted_.push_back({std::move(io), waiter});
+    }
+    submitted_cv_.notify_one();
+  }
+
+  /// Resumes the coroutines whose reads completed, first waiting for one
+  /// if any are in flight. Returns the number resumed.
+  std::size_t Poll() {
+    std::vector<std::coroutine_handle<>> ready;
+    {
+      std::unique_lock lock(mu_);
+      completed_cv_.wait(
+          lock, [this] { return in_flight_ == 0 || !completed_.empty(); });
+      ready.swap(completed_);
+    }
+
+    in_flight_ -= ready.size();
+    for (const auto h : ready) h.resume();
+
+    return ready.size();
+  }
+
+  /// Polls until no reads are in flight.
+  void Run() {
+    while (in_flight_ > 0) Poll();
+  }
+
+  /// Reads submitted and not yet resumed.
+  [[nodiscard]] std::size_t InFlight() const noexcept { return in_flight_; }
+
+ private:
+  struct Op {
+    std::function<void()> io;
+    std::coroutine_handle<> waiter;
+  };
+
+  void Work(std::stop_token st) {
+    while (true) {
+      Op op;
+      {
+        std::unique_lock lock(mu_);
+        submitted_cv_.wait(lock, st, [this] { return !submitted_.empty(); });
+        if (st.stop_requested()) return;
+        op = std::move(submitted_.front());
+        submitted_.pop_front();
+      }
+
+      op.io();
+
+      {
+        std::lock_guard lock(mu_);
+        completed_.push_back(op.waiter);
+      }
+      completed_cv_.notify_one();
+    }
+  }
+
+  std::mutex mu_;
+  std::condition_variable_any submitted_cv_;
+  std::condition_variable completed_cv_;
+  std::deque<Op> submitted_;
+  std::vector<std::coroutine_handle<>> completed_;
+  std::size_t in_flight_ = 0;  // Loop thread only.
+  std::vector<std::jthread> workers_;
+};
+
+// ====================================================================
+// Lookups
+// ====================================================================
+
+/// \brief FetchAwaiter fetches a page from a BufferPool, completing
+///        immediately on a hit and suspending on the IoLoop on a miss.
+class FetchAwaiter {
+ public:
+  FetchAwaiter(IoLoop& loop, BufferPool& pool, PageId id)
+      : loop_(loop), pool_(pool), id_(id) {}
+
+  bool await_ready() {
+    page_ = pool_.TryFetch(id_);
+    return page_.has_value();
+  }
+
+  void await_suspend(std::coroutine_handle<> waiter) {
+    loop_.Submit(
+        [this] {
+          try {
+            page_ = pool_.Fetch(id_);
+          } catch (...) {
+            error_ = std::current_exception();
+          }
+        },
+        waiter);
+  }
+
+  BufferPool::PageHandle await_resume() {
+    if (error_) std::rethrow_exception(error_);
+
+    return std::move(*page_);
+  }
+
+ private:
+  IoLoop& loop_;
+  BufferPool& pool_;
+  PageId id_;
+  std::optional<BufferPool::PageHandle> page_;
+  std::exception_ptr error_;
+};
+
+inline FetchAwaiter FetchAsync(IoLoop& loop, BufferPool& pool, PageId id) {
+  return FetchAwaiter(loop, pool, id);
+}
+
+/// A value found by GetAsync, with its leaf pinned so `value` stays valid.
+struct PinnedValue {
+  BufferPool::PageHandle page;
+  std::span<const std::byte> value;
+  LeafFlag flags = LeafFlag::kNone;
+};
+
+/// Looks up `key` in the tree at `root`, suspending on the IoLoop for
+/// every page missing from the pool. `key` must outlive the task.
+///
+/// Unlike Cursor::Seek() only one page is pinned at a time, so many
+/// lookups can be in flight without holding their whole paths in the pool.
+inline Task<std::optional<PinnedValue>> GetAsync(
+    IoLoop& loop, BufferPool& pool, PageId root,
+    std::span<const std::byte> key, KeySearch search = KeySearch::kBinary) {
+  auto page = co_await FetchAsync(loop, pool, root);
+  while (page->IsBranch()) {
+    const auto index = SearchBranch(*page, key, search);
+    const auto child = page->GetBranchElement(index).pgid;
+    page = co_await FetchAsync(loop, pool, child);
+  }
+
+  const auto index = SearchLeaf(page->LeafElements(), key, search);
+  if (index >= page->count) co_return std::nullopt;
+
+  const auto& elem = page->GetLeafElement(static_cast<std::uint16_t>(index));
+  if (CompareKeys(elem.Key(), key) != 0) co_return std::nullopt;
+
+  const auto value = elem.Value();
+  const auto flags = elem.flags;
+  co_return PinnedValue{std::move(page), value, flags};
+}
+
+}  // namespace boltdb
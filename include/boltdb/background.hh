@@ -0,0 +1,73 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+
+namespace boltdb {
+
+/// Runs a maintenance task on a dedicated thread.
+///
+/// The task runs every `interval`, or sooner when Wake() is called. It
+/// returns true when it made progress and there is more to do, in which case
+/// it is invoked again immediately; false puts the worker back to sleep.
+/// The thread is stopped and joined on destruction.
+class BackgroundWorker {
+ public:
+  using Task = std::function<bool()>;
+
+  BackgroundWorker(Task task, std::chrono::milliseconds interval)
+      : task_(std::move(task)), interval_(interval) {
+    thread_ = std::jthread([this](std::stop_token st) { Run(st); });
+  }
+
+  BackgroundWorker(const BackgroundWorker&) = delete;
+  BackgroundWorker& operator=(const BackgroundWorker&) = delete;
+
+  ~BackgroundWorker() { Stop(); }
+
+  /// Run the task as soon as possible instead of waiting for the interval.
+  void Wake() {
+    {
+      std::lock_guard lock(mu_);
+      woken_ = true;
+    }
+    cv_.notify_one();
+  }
+
+  /// Stop the worker and wait for an in-flight task to finish.
+  void Stop() {
+    if (!thread_.joinable()) return;
+
+    thread_.request_stop();
+    cv_.notify_one();
+    thread_.join();
+  }
+
+ private:
+  void Run(std::stop_token st) {
+    while (!st.stop_requested()) {
+      {
+        std::unique_lock lock(mu_);
+        cv_.wait_for(lock, st, interval_, [this] { return woken_; });
+        woken_ = false;
+      }
+
+      while (!st.stop_requested() && task_()) {
+      }
+    }
+  }
+
+  Task task_;
+  std::chrono::milliseconds interval_;
+  std::mutex mu_;
+  std::condition_variable_any cv_;
+  bool woken_ = false;
+  std::jthread thread_;
+};
+
+}  // namespace boltdb
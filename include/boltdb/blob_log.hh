@@ -0,0 +1,328 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "boltdb/bucket.hh"
+#include "boltdb/endian.hh"
+#include "boltdb/errors.hh"
+#include "boltdb/file.hh"
+#include "boltdb/hash.hh"
+#include "boltdb/node.hh"
+#include "boltdb/page.hh"
+
+namespace boltdb {
+
+/// \brief BlobPointer is what a leaf stores, flagged LeafFlag::kBlobRef, in
+///        place of a value that was separated into the blob log.
+struct BlobPointer {
+  static constexpr std::size_t kEncodedSize = 24;
+
+  std::uint32_t segment = 0;   ///< Blob log segment holding the value.
+  std::uint32_t length = 0;    ///< Value length in bytes.
+  std::uint64_t offset = 0;    ///< Offset of the value in the segment.
+  std::uint64_t checksum = 0;  ///< HashBytes() of the value.
+
+  /// Little-endian encoding: segment, length, offset, checksum.
+  [[nodiscard]] std::array<std::byte, kEncodedSize> Encode() const noexcept {
+    std::array<std::byte, kEncodedSize> b{};
+    StoreLittleEndian32(b.data(), segment);
+    StoreLittleEndian32(b.data() + 4, length);
+    StoreLittleEndian64(b.data() + 8, offset);
+    StoreLittleEndian64(b.data() + 16, checksum);
+
+    return b;
+  }
+
+  [[nodiscard]] static BlobPointer Decode(std::span<const std::byte> b) {
+    assert(b.size() == kEncodedSize);
+
+    return BlobPointer{LoadLittleEndian32(b.data()),
+                       LoadLittleEndian32(b.data() + 4),
+                       LoadLittleEndian64(b.data() + 8),
+                       LoadLittleEndian64(b.data() + 16)};
+  }
+
+  bool operator==(const BlobPointer&) const = default;
+};
+
+/// Options for BlobLog.
+struct BlobLogOptions {
+  /// Values of at least this many bytes are separated from the tree.
+  std::size_t threshold = 4096;
+  /// Size after which appends move on to a new segment.
+  std::uint64_t segment_size = std::uint64_t{64} << 20;
+};
+
+/// \brief BlobLog keeps large values out of the B+tree, as in WiscKey.
+///
+/// Values above the threshold are appended to a sequential log and the leaf
+/// holds only a BlobPointer, so leaves stay dense and key scans read a
+/// fraction of the pages. The log is a directory of numbered segment files;
+/// each record is
+///
+/// ┌──────────────┬──────────────┬──────────────┬─────┬───────┐
+/// │ u32 key size │ u32 val size │ u64 checksum │ key │ value │
+/// └──────────────┴──────────────┴──────────────┴─────┴───────┘
+///
+/// The key is kept so garbage collection can ask the tree whether a record
+/// is still referenced. Collect() copies the live records of an old segment
+/// to the head of the log and reports their new pointers; once the caller
+/// has committed those, Drop() deletes the segment. A crash in between
+/// leaves both copies and the committed pointers stay valid.
+///
+/// Appends are not synced; call Sync() before committing the transaction
+/// that references them. On open, a torn record at the end of the newest
+/// segment is cut off.
+class BlobLog {
+ public:
+  /// Returns whether the record of `key` at `ptr` is still referenced.
+  using IsLive = std::function<bool(std::span<const std::byte> key,
+                                    const BlobPointer& ptr)>;
+  /// Called when a live record has been copied from `from` to `to`.
+  using Relocate =
+      std::function<void(std::span<const std::byte> key,
+                         const BlobPointer& from, const BlobPointer& to)>;
+
+  /// Opens the blob log in `dir`, creating the directory if needed.
+  explicit BlobLog(std::filesystem::path dir, BlobLogOptions options = {})
+      : dir_(std::move(dir)), options_(options) {
+    std::filesystem::create_directories(dir_);
+
+    for (const auto& entry : std::filesystem::directory_iterator(dir_)) {
+      const auto& path = entry.path();
+      if (path.extension() != ".blob") continue;
+      const auto id =
+          static_cast<std::uint32_t>(std::stoul(path.stem().string()));
+      files_.emplace(id, File(path, O_RDWR));
+    }
+
+    if (files_.empty()) {
+      Roll(1);
+    } else {
+      active_ = files_.rbegin()->first;
+      tail_ = Recover(files_.at(active_));
+    }
+  }
+
+  BlobLog(const BlobLog&) = delete;
+  BlobLog& operator=(const BlobLog&) = delete;
+
+  /// Returns whether a value of `size` bytes belongs in the log.
+  [[nodiscard]] bool Separates(std::size_t size) const noexcept {
+    return size >= options_.threshold;
+  }
+
+  /// Appends a record and returns the pointer to its value.
+  BlobPointer Append(std::span<const std::byte> key,
+                     std::span<const std::byte> value) {
+    if (value.size() > kMaxValueSize) ThrowError(Errc::kValueTooLarge);
+
+    std::array<std::byte, kRecordHeaderSize> header{};
+    StoreLittleEndian32(header.data(), static_cast<std::uint32_t>(key.size()));
+    StoreLittleEndian32(header.data() + 4,
+                        static_cast<std::uint32_t>(value.size()));
+    const auto checksum = HashBytes(value);
+    StoreLittleEndian64(header.data() + 8, checksum);
+
+    std::unique_lock lock(mu_);
+    const auto size = kRecordHeaderSize + key.size() + value.size();
+    if (tail_ > 0 && tail_ + size > options_.segment_size) Roll(active_ + 1);
+
+    auto& file = files_.at(active_);
+    const auto offset = tail_;
+    file.WriteAt(header, offset);
+    file.WriteAt(key, offset + kRecordHeaderSize);
+    file.WriteAt(value, offset + kRecordHeaderSize + key.size());
+    tail_ += size;
+
+    return BlobPointer{active_, static_cast<std::uint32_t>(value.size()),
+                       offset + kRecordHeaderSize + key.size(), checksum};
+  }
+
+  /// Reads the value at `ptr`. Throws kChecksumMismatch if it is missing or
+  /// damaged.
+  [[nodiscard]] std::vector<std::byte> Read(const BlobPointer& ptr) const {
+    std::vector<std::byte> value(ptr.length);
+    {
+      std::shared_lock lock(mu_);
+      const auto it = files_.find(ptr.segment);
+      if (it == files_.end() || !it->second.ReadAt(value, ptr.offset)) {
+        ThrowError(Errc::kChecksumMismatch);
+      }
+    }
+    if (HashBytes(value) != ptr.checksum) ThrowError(Errc::kChecksumMismatch);
+
+    return value;
+  }
+
+  /// Flushes appended records to stable storage.
+  void Sync() {
+    std::shared_lock lock(mu_);
+    files_.at(active_).Sync();
+  }
+
+  /// Ids of the segments on disk, oldest first.
+  [[nodiscard]] std::vector<std::uint32_t> Segments() const {
+    std::shared_lock lock(mu_);
+    std::vector<std::uint32_t> ids;
+    for (const auto& [id, file] : files_) ids.push_back(id);
+
+    return ids;
+  }
+
+  /// Copies the records of `segment` that `is_live` accepts to the head of
+  /// the log, calling `relocate` for each. Returns the number moved. The
+  /// segment itself is left in place; see Drop().
+  std::size_t Collect(std::uint32_t segment, const IsLive& is_live,
+                      const Relocate& relocate) {
+    {
+      std::unique_lock lock(mu_);
+      if (segment == active_) Roll(active_ + 1);
+    }
+    const File* file = nullptr;
+    std::uint64_t end = 0;
+    {
+      std::shared_lock lock(mu_);
+      file = &files_.at(segment);
+      end = file->Size();
+    }
+
+    std::size_t moved = 0;
+    std::vector<std::byte> record;
+    for (std::uint64_t offset = 0; offset < end;) {
+      const auto rec = ReadRecord(*file, offset, end, record);
+      if (!rec) ThrowError(Errc::kChecksumMismatch);
+
+      const auto key = std::span<const std::byte>(record).first(rec->ksize);
+      const auto value = std::span<const std::byte>(record).subspan(rec->ksize);
+      const BlobPointer from{segment, static_cast<std::uint32_t>(value.size()),
+                             offset + kRecordHeaderSize + rec->ksize,
+                             rec->checksum};
+      if (is_live(key, from)) {
+        relocate(key, from, Append(key, value));
+        ++moved;
+      }
+      offset += kRecordHeaderSize + record.size();
+    }
+
+    return moved;
+  }
+
+  /// Deletes a segment whose live records have been collected and whose
+  /// relocated pointers are committed. The active segment cannot be
+  /// dropped.
+  void Drop(std::uint32_t segment) {
+    std::unique_lock lock(mu_);
+    assert(segment != active_ && "drop: segment is active");
+
+    files_.erase(segment);
+    std::filesystem::remove(SegmentPath(segment));
+  }
+
+ private:
+  static constexpr std::size_t kRecordHeaderSize = 16;
+
+  struct RecordHeader {
+    std::uint32_t ksize;
+    std::uint32_t vsize;
+    std::uint64_t checksum;
+  };
+
+  [[nodiscard]] std::filesystem::path SegmentPath(std::uint32_t id) const {
+    return dir_ / std::format("{:06}.blob", id);
+  }
+
+  /// Reads the record at `offset` into `record` (key then value). Returns
+  /// nothing if it is cut short by `end` or fails its checksum.
+  static std::optional<RecordHeader> ReadRecord(
+      const File& file, std::uint64_t offset, std::uint64_t end,
+      std::vector<std::byte>& record) {
+    std::array<std::byte, kRecordHeaderSize> header{};
+    if (offset + kRecordHeaderSize > end || !file.ReadAt(header, offset)) {
+      return std::nullopt;
+    }
+
+    const RecordHeader rec{LoadLittleEndian32(header.data()),
+                           LoadLittleEndian32(header.data() + 4),
+                           LoadLittleEndian64(header.data() + 8)};
+    const std::uint64_t size = std::uint64_t{rec.ksize} + rec.vsize;
+    if (offset + kRecordHeaderSize + size > end) return std::nullopt;
+
+    record.resize(static_cast<std::size_t>(size));
+    if (!file.ReadAt(record, offset + kRecordHeaderSize)) return std::nullopt;
+    if (HashBytes(std::span<const std::byte>(record).subspan(rec.ksize)) !=
+        rec.checksum) {
+      return std::nullopt;
+    }
+
+    return rec;
+  }
+
+  /// Returns the end of the last intact record of `file`, truncating
+  /// anything after it.
+  static std::uint64_t Recover(File& file) {
+    const auto end = file.Size();
+    std::vector<std::byte> record;
+    std::uint64_t offset = 0;
+    while (offset < end) {
+      if (!ReadRecord(file, offset, end, record)) break;
+      offset += kRecordHeaderSize + record.size();
+    }
+    if (offset < end) file.Truncate(offset);
+
+    return offset;
+  }
+
+  /// Seals the active segment and starts segment `id`. Requires mu_.
+  void Roll(std::uint32_t id) {
+    if (files_.contains(active_)) files_.at(active_).Sync();
+
+    files_.emplace(id, File(SegmentPath(id), O_RDWR | O_CREAT | O_TRUNC));
+    active_ = id;
+    tail_ = 0;
+  }
+
+  std::filesystem::path dir_;
+  BlobLogOptions options_;
+  mutable std::shared_mutex mu_;
+  std::map<std::uint32_t, File> files_;
+  std::uint32_t active_ = 0;
+  std::uint64_t tail_ = 0;
+};
+
+/// Puts `key` into leaf node `n`, moving the value to `log` and storing
+/// only its BlobPointer if the log separates values of its size.
+inline void PutSeparated(Node& n, BlobLog& log, std::span<const std::byte> key,
+                         std::span<const std::byte> value) {
+  if (!log.Separates(value.size())) {
+    n.Put(key, key, value, PageId{0}, LeafFlag::kNone);
+    return;
+  }
+
+  const auto ptr = log.Append(key, value).Encode();
+  n.Put(key, key, ptr, PageId{0}, LeafFlag::kBlobRef);
+}
+
+/// Returns the value stored in a leaf element with `flags`, reading it from
+/// `log` if it is a blob reference.
+inline std::vector<std::byte> LoadValue(const BlobLog& log, LeafFlag flags,
+                                        std::span<const std::byte> value) {
+  if (flags != LeafFlag::kBlobRef) return {value.begin(), value.end()};
+
+  return log.Read(BlobPointer::Decode(value));
+}
+
+}  // namespace boltdb
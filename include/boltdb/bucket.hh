@@ -1,9 +1,17 @@
 #pragma once
 
+#include <cstddef>
+
 #include "boltdb/type.hh"
 
 namespace boltdb {
 
+/// The maximum length of a key, in bytes.
+inline constexpr std::size_t kMaxKeySize = 32768;
+
+/// The maximum length of a value, in bytes.
+inline constexpr std::size_t kMaxValueSize = (std::size_t{1} << 31) - 2;
+
 /// \brief BucketHeader represents the header of a bucket in BoltDB. It contains
 ///        the root page ID and a sequence number for the bucket.
 struct BucketHeader {
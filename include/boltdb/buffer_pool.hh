@@ -0,0 +1,377 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "boltdb/errors.hh"
+#include "boltdb/file.hh"
+#include "boltdb/page.hh"
+
+namespace boltdb {
+
+/// Options for BufferPool.
+struct BufferPoolOptions {
+  std::size_t page_size = 4096;
+  /// Memory for cached pages, in bytes.
+  std::size_t capacity = std::size_t{256} << 20;
+  /// Clock passes a branch page survives unreferenced; leaves survive one.
+  std::uint8_t branch_weight = 4;
+};
+
+/// \brief BufferPool is a storage mode for files larger than memory: pages
+///        are read with pread into a user-space cache with explicit
+///        eviction, instead of being faulted in through mmap.
+///
+/// Eviction is a clock over the cached pages. A page's reference count is
+/// refreshed on every fetch, to `branch_weight` for branch pages and 1 for
+/// the rest, and the hand decrements it as it passes; so branch pages,
+/// which every lookup crosses, stay cached while leaves cycle through.
+/// Pinned pages are never evicted.
+///
+/// Each fetch returns a pinned PageHandle. A PinnedPath backs a cursor with
+/// the same `const Page*` view as mmap while pinning only the pages on the
+/// cursor's current path, so a scan holds a few pages at a time however
+/// much it reads. Frames are 4096-byte aligned, so the file may be opened
+/// with O_DIRECT to skip the kernel page cache.
+class BufferPool {
+  struct Frame;
+
+ public:
+  /// A pinned page. The page stays cached while the handle lives.
+  class PageHandle {
+   public:
+    PageHandle() = default;
+    PageHandle(PageHandle&& other) noexcept
+        : pool_(std::exchange(other.pool_, nullptr)), frame_(other.frame_) {}
+    PageHandle& operator=(PageHandle&& other) noexcept {
+      if (this != &other) {
+        Release();
+        pool_ = std::exchange(other.pool_, nullptr);
+        frame_ = other.frame_;
+      }
+      return *this;
+    }
+    PageHandle(const PageHandle&) = delete;
+    PageHandle& operator=(const PageHandle&) = delete;
+    ~PageHandle() { Release(); }
+
+    [[nodiscard]] const Page* get() const noexcept {
+      return reinterpret_cast<const Page*>(frame_->data.get());
+    }
+    const Page* operator->() const noexcept { return get(); }
+    const Page& operator*() const noexcept { return *get(); }
+
+   private:
+    friend class BufferPool;
+
+    PageHandle(BufferPool* pool, Frame* frame) : pool_(pool), frame_(frame) {}
+
+    void Release() {
+      if (pool_ != nullptr) pool_->Unpin(*frame_);
+      pool_ = nullptr;
+    }
+
+    BufferPool* pool_ = nullptr;
+    Frame* frame_ = nullptr;
+  };
+
+  BufferPool(File file, BufferPoolOptions options = {})
+      : file_(std::move(file)), options_(options) {
+    assert(options_.page_size >= Page::kHeaderSize);
+  }
+
+  BufferPool(const BufferPool&) = delete;
+  BufferPool& operator=(const BufferPool&) = delete;
+
+  /// Returns page `id`, with its overflow pages, reading it if it is not
+  /// cached. Throws kPoolExhausted if every cached page is pinned and
+  /// kPageOutOfRange if the page, or the overflow run its header claims,
+  /// lies past the end of the file.
+  PageHandle Fetch(PageId id) {
+    std::unique_lock lock(mu_);
+
+    if (const auto it = table_.find(id); it != table_.end()) {
+      auto* frame = it->second;
+      ++frame->pins;
+      loaded_.wait(lock, [frame] { return !frame->loading; });
+      if (frame->failed) {
+        --frame->pins;
+        Recycle(*frame);
+        ThrowError(Errc::kPageOutOfRange);
+      }
+      Touch(*frame);
+      hits_.fetch_add(1, std::memory_order_relaxed);
+
+      return PageHandle(this, frame);
+    }
+
+    misses_.fetch_add(1, std::memory_order_relaxed);
+    auto* frame = Claim(id, options_.page_size);
+    lock.unlock();
+
+    // Other fetches of the page wait on the frame rather than the pool, so
+    // reads of different pages proceed in parallel.
+    bool ok = false;
+    std::exception_ptr error;
+    try {
+      ok = Load(*frame);
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    lock.lock();
+    frame->loading = false;
+    frame->failed = !ok;
+    loaded_.notify_all();
+    if (!ok) {
+      table_.erase(id);
+      Free(*frame);
+      --frame->pins;
+      Recycle(*frame);
+      if (error) std::rethrow_exception(error);
+      ThrowError(Errc::kPageOutOfRange);
+    }
+    Touch(*frame);
+
+    return PageHandle(this, frame);
+  }
+
+  /// Returns page `id` if it is cached and loaded, without doing I/O or
+  /// waiting for a read in progress.
+  std::optional<PageHandle> TryFetch(PageId id) {
+    std::lock_guard lock(mu_);
+    const auto it = table_.find(id);
+    if (it == table_.end() || it->second->loading) return std::nullopt;
+
+    auto* frame = it->second;
+    ++frame->pins;
+    Touch(*frame);
+    hits_.fetch_add(1, std::memory_order_relaxed);
+
+    return PageHandle(this, frame);
+  }
+
+  [[nodiscard]] std::uint64_t Hits() const noexcept {
+    return hits_.load(std::memory_order_relaxed);
+  }
+  [[nodiscard]] std::uint64_t Misses() const noexcept {
+    return misses_.load(std::memory_order_relaxed);
+  }
+  [[nodiscard]] std::uint64_t Evictions() const noexcept {
+    return evictions_.load(std::memory_order_relaxed);
+  }
+
+  /// Bytes held by cached pages.
+  [[nodiscard]] std::size_t Used() const {
+    std::lock_guard lock(mu_);
+    return used_;
+  }
+
+ private:
+  struct AlignedDelete {
+    void operator()(std::byte* p) const {
+      ::operator delete[](p, std::align_val_t{kAlignment});
+    }
+  };
+
+  struct Frame {
+    PageId id{};
+    std::unique_ptr<std::byte[], AlignedDelete> data;
+    std::size_t size = 0;
+    std::uint32_t pins = 0;
+    std::uint8_t ref = 0;
+    bool loading = false;
+    bool failed = false;
+  };
+
+  static constexpr std::size_t kAlignment = 4096;
+
+  [[nodiscard]] std::uint64_t Offset(PageId id) const {
+    return static_cast<std::uint64_t>(id) * options_.page_size;
+  }
+
+  static std::unique_ptr<std::byte[], AlignedDelete> Allocate(
+      std::size_t size) {
+    return std::unique_ptr<std::byte[], AlignedDelete>(
+        new (std::align_val_t{kAlignment}) std::byte[size]);
+  }
+
+  void Touch(Frame& frame) {
+    const auto* p = reinterpret_cast<const Page*>(frame.data.get());
+    frame.ref = p->IsBranch() ? options_.branch_weight : 1;
+  }
+
+  /// Reads the first page into a claimed frame, then the rest of the run
+  /// once its length is known from the header. Returns false at EOF.
+  bool Load(Frame& frame) {
+    const auto page_size = options_.page_size;
+    if (!file_.ReadAt({frame.data.get(), page_size}, Offset(frame.id))) {
+      return false;
+    }
+
+    const auto* p = reinterpret_cast<const Page*>(frame.data.get());
+    const auto size = (std::size_t{p->overflow} + 1) * page_size;
+    if (size == page_size) return true;
+
+    // A corrupt header must not get to evict the cache for a run that is
+    // not there.
+    if (Offset(frame.id) + size > file_.Size()) {
+      ThrowError(Errc::kPageOutOfRange);
+    }
+
+    {
+      std::lock_guard lock(mu_);
+      Resize(frame, size);
+    }
+
+    return file_.ReadAt({frame.data.get() + page_size, size - page_size},
+                        Offset(frame.id) + page_size);
+  }
+
+  /// Takes a free frame of `size` bytes for `id`, pinned and loading,
+  /// evicting as needed. Requires mu_.
+  Frame* Claim(PageId id, std::size_t size) {
+    MakeRoom(size);
+
+    Frame* frame = nullptr;
+    if (!free_.empty()) {
+      frame = free_.back();
+      free_.pop_back();
+    } else {
+      frames_.push_back(std::make_unique<Frame>());
+      frame = frames_.back().get();
+    }
+
+    frame->id = id;
+    frame->data = Allocate(size);
+    frame->size = size;
+    frame->pins = 1;
+    frame->ref = 0;
+    frame->loading = true;
+    frame->failed = false;
+    used_ += size;
+    table_.emplace(id, frame);
+
+    return frame;
+  }
+
+  /// Grows a loading frame to hold a whole overflow run. Requires mu_.
+  void Resize(Frame& frame, std::size_t size) {
+    MakeRoom(size - frame.size);
+
+    auto data = Allocate(size);
+    std::copy_n(frame.data.get(), frame.size, data.get());
+    used_ += size - frame.size;
+    frame.data = std::move(data);
+    frame.size = size;
+  }
+
+  /// Evicts unpinned pages until `size` more bytes fit. Requires mu_.
+  void MakeRoom(std::size_t size) {
+    // Two full turns let every reference count drain to zero.
+    const auto max_steps =
+        frames_.size() * (std::size_t{options_.branch_weight} + 2);
+    for (std::size_t step = 0;
+         used_ + size > options_.capacity && step < max_steps; ++step) {
+      if (frames_.empty()) break;
+      hand_ = (hand_ + 1) % frames_.size();
+
+      auto& f = *frames_[hand_];
+      if (!f.data || f.pins > 0 || f.loading) continue;
+      if (f.ref > 0) {
+        --f.ref;
+        continue;
+      }
+
+      table_.erase(f.id);
+      Free(f);
+      Recycle(f);
+      evictions_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if (used_ + size > options_.capacity) ThrowError(Errc::kPoolExhausted);
+  }
+
+  void Free(Frame& frame) {
+    used_ -= frame.size;
+    frame.data.reset();
+    frame.size = 0;
+  }
+
+  /// Puts a frame on the free list once it holds no page and its last pin
+  /// is gone; a failed load is still pinned by the fetches waiting on it.
+  /// Requires mu_.
+  void Recycle(Frame& frame) {
+    if (!frame.data && frame.pins == 0) free_.push_back(&frame);
+  }
+
+  void Unpin(Frame& frame) {
+    std::lock_guard lock(mu_);
+    assert(frame.pins > 0);
+    --frame.pins;
+  }
+
+  File file_;
+  BufferPoolOptions options_;
+  mutable std::mutex mu_;
+  std::condition_variable loaded_;
+  std::vector<std::unique_ptr<Frame>> frames_;
+  std::vector<Frame*> free_;  // Frames without a page, ready for Claim().
+  std::unordered_map<PageId, Frame*> table_;
+  std::size_t hand_ = 0;
+  std::size_t used_ = 0;
+  std::atomic<std::uint64_t> hits_{0};
+  std::atomic<std::uint64_t> misses_{0};
+  std::atomic<std::uint64_t> evictions_{0};
+};
+
+/// \brief PinnedPath adapts a BufferPool to one cursor, keeping the pages
+///        on the cursor's path pinned and nothing else.
+///
+/// A page is unpinned as soon as the cursor moves off it, so keys and
+/// values the cursor returned stay valid only until it leaves their leaf;
+/// copy them to keep them longer. Each cursor needs its own PinnedPath.
+class PinnedPath {
+ public:
+  explicit PinnedPath(BufferPool& pool) : pool_(&pool) {}
+
+  PinnedPath(const PinnedPath&) = delete;
+  PinnedPath& operator=(const PinnedPath&) = delete;
+
+  /// Pins page `id` as level `level` of the path, unpinning the pages the
+  /// path held at that level and below.
+  const Page* Fetch(PageId id, std::size_t level) {
+    assert(level <= path_.size());
+    path_.resize(level);
+    path_.push_back(pool_->Fetch(id));
+
+    return path_.back().get();
+  }
+
+  /// Pages pinned, one per level of the path.
+  [[nodiscard]] std::size_t Pinned() const noexcept { return path_.size(); }
+
+  /// A resolver for a cursor; valid while the path lives.
+  PathResolver Resolver() {
+    return [this](PageId id, std::size_t level) { return Fetch(id, level); };
+  }
+
+ private:
+  BufferPool* pool_;
+  std::vector<BufferPool::PageHandle> path_;
+};
+
+}  // namespace boltdb
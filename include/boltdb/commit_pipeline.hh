@@ -0,0 +1,266 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <condition_variable>
+#include <coroutine>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "boltdb/type.hh"
+
+namespace boltdb {
+
+/// The durable steps of a commit, run by CommitPipeline's flusher.
+struct CommitStages {
+  /// Makes every page written so far durable, e.g. fdatasync on the file.
+  std::function<void()> sync;
+  /// Writes and syncs the meta page naming `txid` as the latest commit.
+  std::function<void(TransactionID txid)> write_meta;
+};
+
+/// When new readers see a commit made with CommitAsync().
+enum class CommitVisibility {
+  kImmediate,  ///< As soon as it is submitted, before it is durable.
+  kDurable,    ///< Once its meta page is synced; a crash never undoes it.
+};
+
+class CommitPipeline;
+
+/// \brief DurableAwaiter completes once a commit is durable. It can be
+///        waited on like a future or co_awaited.
+///
+/// A suspended coroutine is resumed on the pipeline's flusher thread, so
+/// it should hand heavy work elsewhere and must not block on the pipeline.
+class DurableAwaiter {
+ public:
+  DurableAwaiter(CommitPipeline& pipeline, TransactionID txid)
+      : pipeline_(&pipeline), txid_(txid) {}
+
+  [[nodiscard]] TransactionID TxId() const noexcept { return txid_; }
+
+  /// Returns true once the commit is durable or has failed.
+  [[nodiscard]] bool Ready() const;
+
+  /// Blocks until the commit is durable; rethrows a failure.
+  void Wait() const;
+
+  bool await_ready() const { return Ready(); }
+  bool await_suspend(std::coroutine_handle<> waiter);
+  void await_resume() const { Wait(); }
+
+ private:
+  CommitPipeline* pipeline_;
+  TransactionID txid_;
+};
+
+/// \brief CommitPipeline overlaps a transaction's work with the fsyncs of
+///        the commits before it.
+///
+/// Unlike the Go version, where Commit() writes the pages, fsyncs, writes
+/// the meta page and fsyncs again before the next writer may start, the
+/// writer here only writes its pages and calls Submit(). A flusher thread
+/// runs the syncs while the next transaction builds, spills and writes its
+/// own pages.
+///
+/// Commits reach disk in txid order: the flusher takes every commit queued
+/// since its last pass, syncs the data once for all of them and writes the
+/// meta page of the newest, so a meta page is never durable before the
+/// pages of any earlier commit. Durable() is the newest commit on disk;
+/// readers open their snapshots at it, never at a commit that a crash could
+/// still undo. For the same reason pages freed by a commit must not be
+/// reused until Durable() has passed it.
+///
+/// CommitAsync() makes a commit visible at once by default: Visible()
+/// advances when it is submitted, so readers may see a commit that a crash
+/// would lose. The writer can then release its lock at once and acknowledge
+/// the client after co_awaiting the DurableAwaiter it returns. Passing
+/// CommitVisibility::kDurable keeps the commit hidden until it is durable,
+/// as with Submit(). A commit made visible early also exposes the commits
+/// before it, since its pages build on theirs.
+///
+/// If a stage throws, the pipeline fails: waiters on that commit or later
+/// ones, and every later Submit(), rethrow the error, and Visible() falls
+/// back to Durable().
+class CommitPipeline {
+ public:
+  explicit CommitPipeline(CommitStages stages, TransactionID durable = 0)
+      : stages_(std::move(stages)),
+        submitted_(durable),
+        visible_(durable),
+        durable_(durable) {
+    flusher_ = std::jthread([this](std::stop_token st) { Run(st); });
+  }
+
+  CommitPipeline(const CommitPipeline&) = delete;
+  CommitPipeline& operator=(const CommitPipeline&) = delete;
+
+  /// Flushes every submitted commit, then stops the flusher.
+  ~CommitPipeline() {
+    {
+      std::unique_lock lock(mu_);
+      durable_cv_.wait(lock, [this] { return Settled(); });
+    }
+    flusher_.request_stop();
+    submitted_cv_.notify_one();
+  }
+
+  /// Queues commit `txid`, whose pages are already written, and returns
+  /// without waiting for it to become durable. Txids must increase. The
+  /// commit becomes visible once it is durable.
+  void Submit(TransactionID txid) {
+    Submit(txid, CommitVisibility::kDurable);
+  }
+
+  /// Queues commit `txid` like Submit(), visible as `visibility` says, and
+  /// returns an awaiter for its durability.
+  DurableAwaiter CommitAsync(
+      TransactionID txid,
+      CommitVisibility visibility = CommitVisibility::kImmediate) {
+    Submit(txid, visibility);
+    return DurableAwaiter(*this, txid);
+  }
+
+  /// Blocks until commit `txid` is durable.
+  void WaitDurable(TransactionID txid) {
+    std::unique_lock lock(mu_);
+    assert(txid <= submitted_);
+    durable_cv_.wait(lock, [&] { return Done(txid); });
+    if (durable_ < txid) std::rethrow_exception(error_);
+  }
+
+  /// Blocks until every submitted commit is durable.
+  void Flush() {
+    TransactionID txid;
+    {
+      std::lock_guard lock(mu_);
+      txid = submitted_;
+    }
+    WaitDurable(txid);
+  }
+
+  /// The newest durable commit.
+  [[nodiscard]] TransactionID Durable() const {
+    std::lock_guard lock(mu_);
+    return durable_;
+  }
+
+  /// The newest commit new readers should see.
+  [[nodiscard]] TransactionID Visible() const {
+    std::lock_guard lock(mu_);
+    if (error_) return durable_;
+
+    return std::max(visible_, durable_);
+  }
+
+  /// The newest submitted commit.
+  [[nodiscard]] TransactionID Submitted() const {
+    std::lock_guard lock(mu_);
+    return submitted_;
+  }
+
+ private:
+  friend class DurableAwaiter;
+
+  struct Waiter {
+    TransactionID txid;
+    std::coroutine_handle<> handle;
+  };
+
+  void Submit(TransactionID txid, CommitVisibility visibility) {
+    {
+      std::lock_guard lock(mu_);
+      if (error_) std::rethrow_exception(error_);
+      assert(txid > submitted_ && "commit pipeline: txids must increase");
+      submitted_ = txid;
+      if (visibility == CommitVisibility::kImmediate) visible_ = txid;
+    }
+    submitted_cv_.notify_one();
+  }
+
+  /// Requires mu_.
+  [[nodiscard]] bool Done(TransactionID txid) const {
+    return durable_ >= txid || error_ != nullptr;
+  }
+
+  /// Parks `handle` until `txid` is durable. Returns false, without
+  /// parking, if it already is.
+  bool Park(TransactionID txid, std::coroutine_handle<> handle) {
+    std::lock_guard lock(mu_);
+    if (Done(txid)) return false;
+    waiters_.push_back({txid, handle});
+
+    return true;
+  }
+
+  /// Requires mu_.
+  [[nodiscard]] bool Settled() const {
+    return durable_ == submitted_ || error_ != nullptr;
+  }
+
+  void Run(std::stop_token st) {
+    while (true) {
+      TransactionID target;
+      {
+        std::unique_lock lock(mu_);
+        submitted_cv_.wait(lock, st, [this] { return !Settled(); });
+        if (Settled()) return;
+        target = submitted_;
+      }
+
+      std::exception_ptr error;
+      try {
+        stages_.sync();
+        stages_.write_meta(target);
+      } catch (...) {
+        error = std::current_exception();
+      }
+
+      std::vector<std::coroutine_handle<>> ready;
+      {
+        std::lock_guard lock(mu_);
+        if (error) {
+          error_ = error;
+        } else {
+          durable_ = target;
+        }
+        std::erase_if(waiters_, [&](const Waiter& w) {
+          if (!Done(w.txid)) return false;
+          ready.push_back(w.handle);
+          return true;
+        });
+      }
+      durable_cv_.notify_all();
+      for (const auto h : ready) h.resume();
+    }
+  }
+
+  CommitStages stages_;
+  mutable std::mutex mu_;
+  std::condition_variable_any submitted_cv_;
+  std::condition_variable durable_cv_;
+  TransactionID submitted_;
+  TransactionID visible_;  // Newest commit made visible before durable.
+  TransactionID durable_;
+  std::exception_ptr error_;
+  std::vector<Waiter> waiters_;
+  std::jthread flusher_;
+};
+
+inline bool DurableAwaiter::Ready() const {
+  std::lock_guard lock(pipeline_->mu_);
+  return pipeline_->Done(txid_);
+}
+
+inline void DurableAwaiter::Wait() const { pipeline_->WaitDurable(txid_); }
+
+inline bool DurableAwaiter::await_suspend(std::coroutine_handle<> waiter) {
+  return pipeline_->Park(txid_, waiter);
+}
+
+}  // namespace boltdb
@@ -0,0 +1,267 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "boltdb/errors.hh"
+#include "boltdb/eytzinger.hh"
+#include "boltdb/page.hh"
+#include "boltdb/search.hh"
+
+namespace boltdb {
+
+/// A key/value pair returned by a Cursor. For sub-buckets `flags` is
+/// LeafFlag::kBucket and `value` holds the bucket header.
+struct KeyValue {
+  std::span<const std::byte> key;
+  std::span<const std::byte> value;
+  LeafFlag flags = LeafFlag::kNone;
+};
+
+/// ElemRef represents a reference to an element on a given page.
+struct ElemRef {
+  const Page* page = nullptr;
+  std::size_t index = 0;
+
+  [[nodiscard]] bool IsLeaf() const { return page->IsLeaf(); }
+  [[nodiscard]] std::size_t Count() const { return page->count; }
+};
+
+/// Cursor represents an iterator that can traverse over all key/value pairs
+/// in a bucket in sorted order.
+///
+/// Cursors see the pages of the transaction they were created in. Keys and
+/// values returned from the cursor are only valid for the life of that
+/// transaction. Moving onto a delta leaf throws kUnsupportedPage.
+class Cursor {
+ public:
+  /// `search` selects the in-page search; buckets whose keys are uniformly
+  /// distributed (hashes, random ids) can use KeySearch::kInterpolation.
+  Cursor(PageResolver resolve, PageId root,
+         KeySearch search = KeySearch::kBinary)
+      : resolve_([resolve = std::move(resolve)](PageId id, std::size_t) {
+          return resolve(id);
+        }),
+        root_(root),
+        search_(search) {}
+
+  /// A cursor that tells `resolve` which level of its path each page is
+  /// for, so a BufferPool can keep just that path pinned.
+  Cursor(PathResolver resolve, PageId root,
+         KeySearch search = KeySearch::kBinary)
+      : resolve_(std::move(resolve)), root_(root), search_(search) {}
+
+  /// Moves the cursor to the first item in the bucket and returns its key
+  /// and value. If the bucket is empty then nothing is returned.
+  std::optional<KeyValue> First() {
+    stack_.clear();
+    stack_.push_back(ElemRef{Resolve(root_), 0});
+    GoFirst();
+
+    // If we land on an empty page then move to the next value.
+    if (stack_.back().Count() == 0) return GoNext();
+
+    return Current();
+  }
+
+  /// Moves the cursor to the last item in the bucket and returns its key
+  /// and value. If the bucket is empty then nothing is returned.
+  std::optional<KeyValue> Last() {
+    stack_.clear();
+    const Page* p = Resolve(root_);
+    stack_.push_back(ElemRef{p, p->count > 0 ? p->count - std::size_t{1} : 0});
+    GoLast();
+
+    return Current();
+  }
+
+  /// Moves the cursor to the next item in the bucket and returns its key and
+  /// value. If the cursor is at the end of the bucket then nothing is
+  /// returned.
+  std::optional<KeyValue> Next() { return GoNext(); }
+
+  /// Moves the cursor to the previous item in the bucket and returns its key
+  /// and value. If the cursor is at the beginning of the bucket then nothing
+  /// is returned.
+  std::optional<KeyValue> Prev() {
+    // Attempt to move back one element until we're successful.
+    // Move up the stack as we hit the beginning of each page in our stack.
+    while (!stack_.empty()) {
+      auto& elem = stack_.back();
+      if (elem.index > 0) {
+        --elem.index;
+        break;
+      }
+      stack_.pop_back();
+    }
+
+    // If we've hit the end then return nothing.
+    if (stack_.empty()) return std::nullopt;
+
+    // Move down the stack to find the last element of the last leaf under
+    // this branch.
+    GoLast();
+
+    return Current();
+  }
+
+  /// Moves the cursor to a given key and returns it. If the key does not
+  /// exist then the next key is used. If no keys follow, nothing is
+  /// returned.
+  ///
+  /// Unlike the Go version, which always restarts at the root, a positioned
+  /// cursor first checks which level of its current stack still covers the
+  /// key and only descends from there. Seeks that land in the same or a
+  /// nearby leaf, as in merge joins, skip most of the branch pages.
+  std::optional<KeyValue> Seek(std::span<const std::byte> key) {
+    if (stack_.empty()) {
+      stack_.push_back(ElemRef{Resolve(root_), 0});
+    } else {
+      stack_.resize(FingerLevel(key) + 1);
+    }
+    SearchFrom(key);
+
+    // If we ended up after the last element of a page then move to the next
+    // one.
+    if (stack_.back().index >= stack_.back().Count()) return GoNext();
+
+    return Current();
+  }
+
+ private:
+  /// Every resolved page is pushed right away, so the stack size is the
+  /// level it is for.
+  const Page* Resolve(PageId id) const {
+    const Page* p = resolve_(id, stack_.size());
+    assert(p != nullptr);
+    if (p->IsDeltaLeaf()) ThrowError(Errc::kUnsupportedPage);
+    assert(p->IsBranch() || p->IsLeaf());
+
+    return p;
+  }
+
+  /// Moves the cursor to the first leaf element under the last page in the
+  /// stack.
+  void GoFirst() {
+    while (!stack_.back().IsLeaf()) {
+      const auto& ref = stack_.back();
+      const auto pgid = ref.page->GetBranchElement(ref.index).pgid;
+      stack_.push_back(ElemRef{Resolve(pgid), 0});
+    }
+  }
+
+  /// Moves the cursor to the last leaf element under the last page in the
+  /// stack.
+  void GoLast() {
+    while (!stack_.back().IsLeaf()) {
+      const auto& ref = stack_.back();
+      const auto pgid = ref.page->GetBranchElement(ref.index).pgid;
+      const Page* p = Resolve(pgid);
+      stack_.push_back(
+          ElemRef{p, p->count > 0 ? p->count - std::size_t{1} : 0});
+    }
+  }
+
+  /// Moves to the next leaf element and returns the key and value.
+  std::optional<KeyValue> GoNext() {
+    while (true) {
+      // Attempt to move over one element until we're successful.
+      // Move up the stack as we hit the end of each page in our stack.
+      std::size_t i = stack_.size();
+      for (; i > 0; --i) {
+        auto& elem = stack_[i - 1];
+        if (elem.index + 1 < elem.Count()) {
+          ++elem.index;
+          break;
+        }
+      }
+
+      // If we've hit the root page then stop and return. This will leave
+      // the cursor on the last element of the last page.
+      if (i == 0) return std::nullopt;
+
+      // Otherwise start from where we left off in the stack and find the
+      // first element of the first leaf page.
+      stack_.resize(i);
+      GoFirst();
+
+      // If this is an empty page then restart and move back up the stack.
+      if (stack_.back().Count() == 0) continue;
+
+      return Current();
+    }
+  }
+
+  /// Returns the deepest level of the stack whose page covers `key`, i.e.
+  /// the level a search for `key` has to restart from. Level zero is the
+  /// root, which covers every key.
+  ///
+  /// A child reached through branch element i receives the keys in
+  /// [key(i), key(i + 1)), with element 0 also taking everything below and
+  /// the last element everything above, bounded by the parent's own range.
+  std::size_t FingerLevel(std::span<const std::byte> key) const {
+    std::optional<std::span<const std::byte>> lo;
+    std::optional<std::span<const std::byte>> hi;
+    std::size_t level = 0;
+
+    for (std::size_t i = 1; i < stack_.size(); ++i) {
+      const auto& parent = stack_[i - 1];
+      if (parent.index > 0) {
+        lo = parent.page->GetBranchElement(parent.index).Key();
+      }
+      if (parent.index + 1 < parent.Count()) {
+        hi = parent.page->GetBranchElement(parent.index + 1).Key();
+      }
+
+      if (lo && CompareKeys(key, *lo) < 0) break;
+      if (hi && CompareKeys(key, *hi) >= 0) break;
+      level = i;
+    }
+
+    return level;
+  }
+
+  /// Searches for `key` below the last page in the stack.
+  void SearchFrom(std::span<const std::byte> key) {
+    while (true) {
+      auto& ref = stack_.back();
+
+      // If we're on a leaf page then find the specific element.
+      if (ref.IsLeaf()) {
+        ref.index = SearchLeaf(ref.page->LeafElements(), key, search_);
+        return;
+      }
+
+      // Find the last element not greater than the key, or the first one.
+      const auto index = SearchBranch(*ref.page, key, search_);
+      ref.index = index;
+
+      const auto pgid = ref.page->GetBranchElement(index).pgid;
+      stack_.push_back(ElemRef{Resolve(pgid), 0});
+    }
+  }
+
+  /// Returns the key and value of the current leaf element.
+  [[nodiscard]] std::optional<KeyValue> Current() const {
+    const auto& ref = stack_.back();
+
+    // If the cursor is pointing to the end of page/node then return nothing.
+    if (ref.Count() == 0 || ref.index >= ref.Count()) return std::nullopt;
+
+    const auto& elem =
+        ref.page->GetLeafElement(static_cast<std::uint16_t>(ref.index));
+
+    return KeyValue{elem.Key(), elem.Value(), elem.flags};
+  }
+
+  PathResolver resolve_;
+  PageId root_;
+  KeySearch search_;
+  std::vector<ElemRef> stack_;
+};
+
+}  // namespace boltdb
@@ -0,0 +1,167 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "boltdb/endian.hh"
+#include "boltdb/hash.hh"
+#include "boltdb/node.hh"
+#include "boltdb/page.hh"
+
+namespace boltdb {
+
+/// Name of the hidden sub-bucket holding a bucket's deduplicated values.
+inline constexpr std::string_view kContentBucketName{"\0content", 8};
+
+/// Values of at least this many bytes are deduplicated by default.
+inline constexpr std::size_t kDefaultDedupThreshold = 1024;
+
+/// \brief ContentRef names a deduplicated value by its 128-bit hash. A leaf
+///        flagged LeafFlag::kContentRef stores the 16-byte encoding.
+///
+/// The content sub-bucket maps each encoding to
+///
+/// ┌──────────────────────────┬───────────┐
+/// │ u64 refcount (little-e.) │ value …   │
+/// └──────────────────────────┴───────────┘
+///
+/// and a value is dropped when its last reference goes. Values whose hash
+/// is already taken by different content (a collision) are stored inline
+/// instead, so a reference always resolves to the bytes that were put.
+struct ContentRef {
+  static constexpr std::size_t kEncodedSize = 16;
+
+  Hash128 hash;
+
+  [[nodiscard]] static ContentRef Of(std::span<const std::byte> value) {
+    return ContentRef{HashBytes128(value)};
+  }
+
+  /// Big-endian hi then lo.
+  [[nodiscard]] std::array<std::byte, kEncodedSize> Encode() const noexcept {
+    std::array<std::byte, kEncodedSize> b{};
+    StoreBigEndian64(b.data(), hash.hi);
+    StoreBigEndian64(b.data() + 8, hash.lo);
+
+    return b;
+  }
+
+  [[nodiscard]] static ContentRef Decode(std::span<const std::byte> b) {
+    assert(b.size() == kEncodedSize);
+
+    return ContentRef{
+        Hash128{LoadBigEndian64(b.data()), LoadBigEndian64(b.data() + 8)}};
+  }
+};
+
+namespace detail {
+
+inline constexpr std::size_t kRefCountSize = 8;
+
+/// Drops one reference to `ref`, deleting the value with the last one.
+inline void ReleaseContent(Node& content, std::span<const std::byte> ref) {
+  content.Update(ref, [](auto stored) -> std::optional<std::vector<std::byte>> {
+    assert(stored && "release: dangling content reference");
+    const auto refs = LoadLittleEndian64(stored->data());
+    if (refs <= 1) return std::nullopt;
+
+    std::vector<std::byte> out(stored->begin(), stored->end());
+    StoreLittleEndian64(out.data(), refs - 1);
+
+    return out;
+  });
+}
+
+}  // namespace detail
+
+/// Puts `key` into leaf node `data`. Values of at least `threshold` bytes
+/// are kept once in the `content` node and `data` stores a reference;
+/// smaller ones, and hash collisions, are stored inline. A reference held
+/// by the previous value of `key` is released.
+inline void PutDeduped(Node& data, Node& content,
+                       std::span<const std::byte> key,
+                       std::span<const std::byte> value,
+                       std::size_t threshold = kDefaultDedupThreshold) {
+  std::optional<std::array<std::byte, ContentRef::kEncodedSize>> old;
+  if (const auto* inode = data.Find(key);
+      inode != nullptr && inode->flags == LeafFlag::kContentRef) {
+    old.emplace();
+    std::copy_n(inode->Value().begin(), old->size(), old->begin());
+  }
+
+  bool shared = false;
+  const auto ref = ContentRef::Of(value).Encode();
+  if (value.size() >= threshold) {
+    // Take the new reference before releasing the old one, so re-putting
+    // the same value never drops it.
+    content.Update(ref, [&](auto stored) {
+      std::vector<std::byte> out;
+      if (!stored) {
+        out.resize(detail::kRefCountSize);
+        StoreLittleEndian64(out.data(), 1);
+        out.insert(out.end(), value.begin(), value.end());
+        shared = true;
+      } else if (std::ranges::equal(
+                     stored->subspan(detail::kRefCountSize), value)) {
+        out.assign(stored->begin(), stored->end());
+        StoreLittleEndian64(out.data(), LoadLittleEndian64(out.data()) + 1);
+        shared = true;
+      } else {
+        out.assign(stored->begin(), stored->end());
+      }
+
+      return std::optional(std::move(out));
+    });
+  }
+
+  if (shared) {
+    data.Put(key, key, ref, PageId{0}, LeafFlag::kContentRef);
+  } else {
+    data.Put(key, key, value, PageId{0}, LeafFlag::kNone);
+  }
+  if (old) detail::ReleaseContent(content, *old);
+}
+
+/// Deletes `key` from `data`, releasing its content reference.
+inline void DeleteDeduped(Node& data, Node& content,
+                          std::span<const std::byte> key) {
+  const auto* inode = data.Find(key);
+  if (inode == nullptr) return;
+
+  if (inode->flags == LeafFlag::kContentRef) {
+    const auto ref = inode->Value();
+    std::array<std::byte, ContentRef::kEncodedSize> copy{};
+    std::copy_n(ref.begin(), copy.size(), copy.begin());
+    detail::ReleaseContent(content, copy);
+  }
+  data.Del(key);
+}
+
+/// Returns the value stored in a leaf element with `flags`, looking it up
+/// in `content` if it is a reference. The result is a view into the node.
+inline std::span<const std::byte> LoadDeduped(
+    const Node& content, LeafFlag flags, std::span<const std::byte> value) {
+  if (flags != LeafFlag::kContentRef) return value;
+
+  const auto* inode = content.Find(value);
+  assert(inode != nullptr && "load: dangling content reference");
+
+  return inode->Value().subspan(detail::kRefCountSize);
+}
+
+/// Number of references to the value named by `ref`, zero if unknown.
+inline std::uint64_t ContentRefCount(const Node& content,
+                                     std::span<const std::byte> ref) {
+  const auto* inode = content.Find(ref);
+
+  return inode == nullptr ? 0 : LoadLittleEndian64(inode->Value().data());
+}
+
+}  // namespace boltdb
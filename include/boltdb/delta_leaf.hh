@@ -0,0 +1,399 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "boltdb/endian.hh"
+#include "boltdb/node.hh"
+#include "boltdb/page.hh"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define BOLTDB_HAVE_AVX2 1
+#include <immintrin.h>
+#define BOLTDB_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace boltdb {
+
+/// A delta leaf stores the keys of a leaf whose keys are all 8-byte
+/// big-endian integers (timestamps, sequence numbers) as delta-of-delta
+/// blocks instead of one LeafElement plus key copy per entry.
+///
+/// ┌──────────────────────────────────────────────────────────────────┐
+/// │ Page Header │ count │ nblocks │ DeltaBlockHead[nblocks] │ bits … │
+/// │  … pad │ value_end[count] (u32) │ value bytes …                  │
+/// └──────────────────────────────────────────────────────────────────┘
+///
+/// Each block covers up to kDeltaBlockKeys keys. Its head stores the first
+/// key and the first delta; every further key is stored as the zigzag
+/// encoded change of delta, bit-packed at the block's width. Keys 1 ms
+/// apart have a change of delta of zero and pack into zero bits, so a block
+/// of 128 such keys costs only its 24-byte head.
+///
+/// Lookups binary search the block heads and decode a single block. On x86
+/// CPUs with AVX2 the packed deltas are unpacked four at a time; the prefix
+/// sums that turn them back into keys carry a dependency from one key to
+/// the next and stay scalar.
+///
+/// Node::Read() and Cursor reject delta leaves with kUnsupportedPage; they
+/// are read through DeltaLeafView.
+inline constexpr std::size_t kDeltaBlockKeys = 128;
+
+struct DeltaBlockHead {
+  std::uint64_t first;        ///< First key of the block.
+  std::uint64_t first_delta;  ///< Second key minus the first key.
+  std::uint32_t offset;       ///< Byte offset of the block's bits.
+  std::uint8_t width;         ///< Bits per packed delta-of-delta.
+  std::uint8_t count;         ///< Keys in the block, minus one.
+  std::uint16_t unused;
+};
+
+static_assert(sizeof(DeltaBlockHead) == 24);
+static_assert(kDeltaBlockKeys - 1 <= 0xFF);
+
+namespace detail {
+
+inline constexpr std::size_t kDeltaLeafHeaderSize = 2 * sizeof(std::uint32_t);
+
+/// Padding after the bit stream so ReadBits() may always load 8 bytes.
+inline constexpr std::size_t kDeltaBitsPadding = 8;
+
+constexpr std::uint64_t ZigZag(std::uint64_t v) noexcept {
+  return (v << 1) ^ (0 - (v >> 63));
+}
+
+constexpr std::uint64_t UnZigZag(std::uint64_t v) noexcept {
+  return (v >> 1) ^ (0 - (v & 1));
+}
+
+inline std::uint64_t ReadBits(const std::byte* base, std::size_t bitpos,
+                              unsigned width) noexcept {
+  if (width == 0) return 0;
+
+  const std::byte* p = base + bitpos / 8;
+  const unsigned shift = bitpos % 8;
+  std::uint64_t v = LoadLittleEndian64(p) >> shift;
+  if (shift + width > 64) {
+    v |= std::to_integer<std::uint64_t>(p[8]) << (64 - shift);
+  }
+
+  return width == 64 ? v : v & ((std::uint64_t{1} << width) - 1);
+}
+
+/// Unpacks `n` consecutive values of `width` bits starting at `base`.
+inline void UnpackBits(const std::byte* base, unsigned width, std::size_t n,
+                       std::uint64_t* out) noexcept {
+  for (std::size_t i = 0; i < n; ++i) out[i] = ReadBits(base, i * width, width);
+}
+
+#ifdef BOLTDB_HAVE_AVX2
+/// Widest value UnpackBitsAvx2() handles: one 8-byte load per value must
+/// hold all its bits after a shift of up to 7.
+inline constexpr unsigned kMaxAvx2UnpackWidth = 57;
+
+inline bool HaveAvx2() noexcept {
+  static const bool avx2 = __builtin_cpu_supports("avx2");
+  return avx2;
+}
+
+/// UnpackBits() four values at a time. Each lane gathers the 8 bytes
+/// holding its value, then shifts and masks it into place.
+BOLTDB_TARGET_AVX2 inline void UnpackBitsAvx2(const std::byte* base,
+                                              unsigned width, std::size_t n,
+                                              std::uint64_t* out) noexcept {
+  assert(width <= kMaxAvx2UnpackWidth);
+
+  const auto w = static_cast<long long>(width);
+  const __m256i mask = _mm256_set1_epi64x(
+      static_cast<long long>((std::uint64_t{1} << width) - 1));
+  const __m256i seven = _mm256_set1_epi64x(7);
+  __m256i pos = _mm256_setr_epi64x(0, w, 2 * w, 3 * w);
+  const __m256i step = _mm256_set1_epi64x(4 * w);
+  const auto* src = reinterpret_cast<const long long*>(base);
+
+  std::size_t i = 0;
+  for (; i + 4 <= n; i += 4) {
+    const __m256i offsets = _mm256_srli_epi64(pos, 3);
+    const __m256i shifts = _mm256_and_si256(pos, seven);
+    __m256i v = _mm256_i64gather_epi64(src, offsets, 1);
+    v = _mm256_and_si256(_mm256_srlv_epi64(v, shifts), mask);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), v);
+    pos = _mm256_add_epi64(pos, step);
+  }
+  for (; i < n; ++i) out[i] = ReadBits(base, i * width, width);
+}
+#endif
+
+/// UnpackBits() with the fastest code the CPU supports.
+inline void UnpackDeltas(const std::byte* base, unsigned width, std::size_t n,
+                         std::uint64_t* out) noexcept {
+#ifdef BOLTDB_HAVE_AVX2
+  if (width <= kMaxAvx2UnpackWidth && HaveAvx2()) {
+    return UnpackBitsAvx2(base, width, n, out);
+  }
+#endif
+  UnpackBits(base, width, n, out);
+}
+
+inline void WriteBits(std::byte* base, std::size_t bitpos, unsigned width,
+                      std::uint64_t v) noexcept {
+  for (unsigned i = 0; i < width; ++i, ++bitpos) {
+    if ((v >> i) & 1) base[bitpos / 8] |= std::byte{1} << (bitpos % 8);
+  }
+}
+
+/// Change of delta between the keys at i - 2, i - 1 and i, zigzag encoded.
+inline std::uint64_t DeltaOfDelta(const Inodes& inodes, std::size_t i) {
+  const auto k0 = KeyToUint64(inodes[i - 2].Key());
+  const auto k1 = KeyToUint64(inodes[i - 1].Key());
+  const auto k2 = KeyToUint64(inodes[i].Key());
+
+  return ZigZag((k2 - k1) - (k1 - k0));
+}
+
+inline unsigned BlockWidth(const Inodes& inodes, std::size_t first,
+                           std::size_t last) {
+  std::uint64_t bits = 0;
+  for (std::size_t i = first + 2; i < last; ++i) {
+    bits |= DeltaOfDelta(inodes, i);
+  }
+
+  return static_cast<unsigned>(std::bit_width(bits));
+}
+
+}  // namespace detail
+
+/// Returns true if the inodes can be written as a delta leaf: plain values
+/// under strictly ascending 8-byte keys.
+inline bool CanDeltaEncode(const Inodes& inodes) {
+  if (inodes.empty()) return false;
+
+  for (std::size_t i = 0; i < inodes.size(); ++i) {
+    if (inodes[i].flags != LeafFlag::kNone || inodes[i].key.size() != 8) {
+      return false;
+    }
+    if (i > 0 && CompareKeys(inodes[i - 1].Key(), inodes[i].Key()) >= 0) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+/// Size of the key section (counts, block heads and packed bits).
+inline std::size_t DeltaKeysSize(const Inodes& inodes) {
+  const auto nblocks = (inodes.size() + kDeltaBlockKeys - 1) / kDeltaBlockKeys;
+  std::size_t bits = 0;
+
+  for (std::size_t first = 0; first < inodes.size(); first += kDeltaBlockKeys) {
+    const auto last = std::min(first + kDeltaBlockKeys, inodes.size());
+    if (last - first > 2) {
+      const auto width = detail::BlockWidth(inodes, first, last);
+      bits += ((last - first - 2) * width + 7) / 8;
+    }
+  }
+
+  return detail::kDeltaLeafHeaderSize + nblocks * sizeof(DeltaBlockHead) +
+         bits + detail::kDeltaBitsPadding;
+}
+
+/// Size of the whole page after WriteDeltaLeaf().
+inline std::size_t DeltaLeafSize(const Inodes& inodes) {
+  auto sz = Page::kHeaderSize + DeltaKeysSize(inodes);
+  sz = (sz + alignof(std::uint32_t) - 1) & ~(alignof(std::uint32_t) - 1);
+  sz += inodes.size() * sizeof(std::uint32_t);
+  for (const auto& inode : inodes) sz += inode.value.size();
+
+  return sz;
+}
+
+/// Writes the inodes onto `p` as a delta leaf. The inodes must satisfy
+/// CanDeltaEncode() and the page must be at least DeltaLeafSize() bytes.
+inline void WriteDeltaLeaf(const Inodes& inodes, Page& p) {
+  assert(CanDeltaEncode(inodes));
+  assert(inodes.size() < 0xFFFF && "inode overflow");
+
+  const auto count = static_cast<std::uint32_t>(inodes.size());
+  const auto nblocks = static_cast<std::uint32_t>(
+      (count + kDeltaBlockKeys - 1) / kDeltaBlockKeys);
+
+  p.flags = PageFlag::kDeltaLeaf;
+  p.count = static_cast<std::uint16_t>(count);
+
+  std::byte* data = p.DataPtr();
+  std::memcpy(data, &count, sizeof(count));
+  std::memcpy(data + sizeof(count), &nblocks, sizeof(nblocks));
+
+  auto* heads = data + detail::kDeltaLeafHeaderSize;
+  std::byte* bits = heads + nblocks * sizeof(DeltaBlockHead);
+  std::size_t offset = 0;
+
+  for (std::uint32_t b = 0; b < nblocks; ++b) {
+    const std::size_t first = b * kDeltaBlockKeys;
+    const std::size_t last =
+        std::min<std::size_t>(first + kDeltaBlockKeys, count);
+    const auto width = detail::BlockWidth(inodes, first, last);
+
+    DeltaBlockHead head{};
+    head.first = KeyToUint64(inodes[first].Key());
+    if (last - first > 1) {
+      head.first_delta = KeyToUint64(inodes[first + 1].Key()) - head.first;
+    }
+    head.offset = static_cast<std::uint32_t>(offset);
+    head.width = static_cast<std::uint8_t>(width);
+    head.count = static_cast<std::uint8_t>(last - first - 1);
+    std::memcpy(heads + b * sizeof(DeltaBlockHead), &head, sizeof(head));
+
+    if (last - first > 2) {
+      const auto nbytes = ((last - first - 2) * width + 7) / 8;
+      std::memset(bits + offset, 0, nbytes);
+      for (std::size_t i = first + 2; i < last; ++i) {
+        detail::WriteBits(bits + offset, (i - first - 2) * width, width,
+                          detail::DeltaOfDelta(inodes, i));
+      }
+      offset += nbytes;
+    }
+  }
+  std::memset(bits + offset, 0, detail::kDeltaBitsPadding);
+
+  // Value end offsets, then the values themselves.
+  auto pos = static_cast<std::size_t>(bits + offset +
+                                      detail::kDeltaBitsPadding -
+                                      reinterpret_cast<std::byte*>(&p));
+  pos = (pos + alignof(std::uint32_t) - 1) & ~(alignof(std::uint32_t) - 1);
+  std::byte* ends = reinterpret_cast<std::byte*>(&p) + pos;
+  std::byte* values = ends + count * sizeof(std::uint32_t);
+  std::uint32_t end = 0;
+
+  for (std::uint32_t i = 0; i < count; ++i) {
+    const auto& value = inodes[i].value;
+    if (!value.empty()) std::memcpy(values + end, value.data(), value.size());
+    end += static_cast<std::uint32_t>(value.size());
+    std::memcpy(ends + i * sizeof(end), &end, sizeof(end));
+  }
+}
+
+/// Read-only view over a page written by WriteDeltaLeaf().
+class DeltaLeafView {
+ public:
+  explicit DeltaLeafView(const Page& p) {
+    assert(p.IsDeltaLeaf());
+
+    const std::byte* data = p.DataPtr();
+    std::memcpy(&count_, data, sizeof(count_));
+    std::memcpy(&nblocks_, data + sizeof(count_), sizeof(nblocks_));
+    heads_ = data + detail::kDeltaLeafHeaderSize;
+    bits_ = heads_ + nblocks_ * sizeof(DeltaBlockHead);
+
+    std::size_t bits_size = 0;
+    if (nblocks_ > 0) {
+      const auto last = Head(nblocks_ - 1);
+      bits_size = last.offset;
+      if (last.count > 1) bits_size += ((last.count - 1) * last.width + 7) / 8;
+    }
+
+    auto pos = static_cast<std::size_t>(bits_ + bits_size +
+                                        detail::kDeltaBitsPadding -
+                                        reinterpret_cast<const std::byte*>(&p));
+    pos = (pos + alignof(std::uint32_t) - 1) & ~(alignof(std::uint32_t) - 1);
+    ends_ = reinterpret_cast<const std::byte*>(&p) + pos;
+    values_ = ends_ + count_ * sizeof(std::uint32_t);
+  }
+
+  [[nodiscard]] std::size_t Count() const noexcept { return count_; }
+
+  /// Key at index `i` as an integer.
+  [[nodiscard]] std::uint64_t KeyAt(std::size_t i) const {
+    assert(i < count_);
+
+    std::array<std::uint64_t, kDeltaBlockKeys> keys;
+    DecodeBlock(i / kDeltaBlockKeys, keys);
+
+    return keys[i % kDeltaBlockKeys];
+  }
+
+  [[nodiscard]] std::span<const std::byte> ValueAt(std::size_t i) const {
+    assert(i < count_);
+
+    const auto begin = i == 0 ? 0 : ValueEnd(i - 1);
+    return {values_ + begin, ValueEnd(i) - begin};
+  }
+
+  /// Index of the first key not less than `key`, or Count() if none.
+  [[nodiscard]] std::size_t LowerBound(std::uint64_t key) const {
+    if (count_ == 0) return 0;
+
+    // Find the last block whose first key is <= key.
+    std::size_t lo = 0;
+    std::size_t hi = nblocks_;
+    while (hi - lo > 1) {
+      const auto mid = lo + (hi - lo) / 2;
+      if (Head(mid).first <= key) {
+        lo = mid;
+      } else {
+        hi = mid;
+      }
+    }
+
+    std::array<std::uint64_t, kDeltaBlockKeys> keys;
+    const auto n = DecodeBlock(lo, keys);
+    const auto it = std::lower_bound(keys.begin(), keys.begin() + n, key);
+
+    return lo * kDeltaBlockKeys + static_cast<std::size_t>(it - keys.begin());
+  }
+
+  /// Decodes all keys of block `b` into `out`. Returns the number of keys.
+  std::size_t DecodeBlock(
+      std::size_t b, std::array<std::uint64_t, kDeltaBlockKeys>& out) const {
+    assert(b < nblocks_);
+
+    const auto head = Head(b);
+    const std::size_t n = head.count + std::size_t{1};
+    const std::byte* bits = bits_ + head.offset;
+
+    // Unpack first, then run the prefix sums. The unpack has no
+    // loop-carried dependency, so it runs several values at a time.
+    if (n > 2) detail::UnpackDeltas(bits, head.width, n - 2, out.data() + 2);
+
+    out[0] = head.first;
+    if (n > 1) out[1] = head.first + head.first_delta;
+
+    std::uint64_t delta = head.first_delta;
+    for (std::size_t i = 2; i < n; ++i) {
+      delta += detail::UnZigZag(out[i]);
+      out[i] = out[i - 1] + delta;
+    }
+
+    return n;
+  }
+
+ private:
+  [[nodiscard]] DeltaBlockHead Head(std::size_t b) const noexcept {
+    DeltaBlockHead head;
+    std::memcpy(&head, heads_ + b * sizeof(DeltaBlockHead), sizeof(head));
+
+    return head;
+  }
+
+  [[nodiscard]] std::uint32_t ValueEnd(std::size_t i) const noexcept {
+    std::uint32_t end;
+    std::memcpy(&end, ends_ + i * sizeof(end), sizeof(end));
+
+    return end;
+  }
+
+  std::uint32_t count_ = 0;
+  std::uint32_t nblocks_ = 0;
+  const std::byte* heads_ = nullptr;
+  const std::byte* bits_ = nullptr;
+  const std::byte* ends_ = nullptr;
+  const std::byte* values_ = nullptr;
+};
+
+}  // namespace boltdb
@@ -0,0 +1,348 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <list>
+#include <optional>
+#include <span>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "boltdb/errors.hh"
+#include "boltdb/file.hh"
+#include "boltdb/memory_tracker.hh"
+#include "boltdb/node.hh"
+#include "boltdb/page.hh"
+
+namespace boltdb {
+
+/// Options for DirtyNodes.
+struct SpillOptions {
+  std::size_t page_size = 4096;
+  /// Bytes of dirty nodes kept in memory before the coldest are spilled.
+  std::size_t budget = std::size_t{64} << 20;
+};
+
+/// Page allocation for spilled nodes, e.g. from the transaction's freelist.
+struct SpillPages {
+  /// Allocates `count` contiguous pages and returns the first.
+  std::function<PageId(std::size_t count)> allocate;
+  /// Returns pages given out by `allocate`. Should not throw: a failure
+  /// while the DirtyNodes is destroyed is dropped and leaks the pages.
+  std::function<void(PageId id, std::size_t count)> free;
+};
+
+/// \brief DirtyNodes holds the nodes a write transaction has modified,
+///        within a memory budget.
+///
+/// Unlike the Go version, which keeps every dirty node in memory until
+/// commit, nodes beyond the budget are spilled: the least recently used
+/// ones are written to newly allocated pages and dropped, and are read back
+/// on the next Get(). Spill pages are never referenced by a meta page, so
+/// they are freed when their node is reloaded, released or rolled back.
+///
+/// Nodes are measured with Node::MemoryUsage(), the heap they hold, not
+/// the size of the page they would be written to. Get() returns a node
+/// read-only; changes go through Put() and Del() so every byte a node
+/// gains is counted.
+///
+/// With a MemoryTracker, nodes in memory are charged as kNodes, the keys
+/// kept for spilled nodes as kKeys and spill buffers as kPages. Add(),
+/// Put() and reloads fail with kMemoryLimitExceeded rather than go over
+/// the tracker's limit.
+class DirtyNodes {
+ public:
+  using Id = std::uint64_t;
+
+  DirtyNodes(File& file, SpillPages pages, SpillOptions options = {},
+             MemoryTracker* tracker = nullptr)
+      : file_(file),
+        pages_(std::move(pages)),
+        options_(options),
+        tracker_(tracker) {
+    assert(options_.page_size >= Page::kHeaderSize);
+  }
+
+  DirtyNodes(const DirtyNodes&) = delete;
+  DirtyNodes& operator=(const DirtyNodes&) = delete;
+
+  /// Rolls back; an exception from `free` is dropped rather than thrown
+  /// out of the destructor.
+  ~DirtyNodes() {
+    try {
+      Rollback();
+    } catch (...) {
+    }
+  }
+
+  /// Takes a dirty node and returns the id to Get() it by.
+  Id Add(Node node) {
+    const auto bytes = node.MemoryUsage();
+    ChargeMemory(MemoryCategory::kNodes, bytes);
+
+    const auto id = next_++;
+    auto& e = entries_[id];
+    e.bytes = bytes;
+    e.node.emplace(std::move(node));
+    lru_.push_front(id);
+    e.lru = lru_.begin();
+    bytes_ += e.bytes;
+
+    SpillExcept(id);
+
+    return id;
+  }
+
+  /// Returns node `id`, reading it back if it was spilled. The reference is
+  /// valid until the next call that takes an id.
+  const Node& Get(Id id) {
+    auto& e = Use(id);
+    SpillExcept(id);
+
+    return *e.node;
+  }
+
+  /// Node::Put() on node `id`, charging the growth first. Throws
+  /// kMemoryLimitExceeded, leaving the node unchanged, if the tracker's
+  /// limit would be exceeded.
+  void Put(Id id, std::span<const std::byte> old_key,
+           std::span<const std::byte> new_key, std::span<const std::byte> value,
+           PageId pgid, LeafFlag flags) {
+    auto& e = Use(id);
+    auto& node = *e.node;
+
+    // At most new key and value buffers, and the inode array doubling to
+    // make room for an insert.
+    auto growth = Node::kHeapBlockOverhead * 2 + new_key.size() + value.size();
+    const auto& inodes = node.GetInodes();
+    if (node.Find(old_key) == nullptr && inodes.size() == inodes.capacity()) {
+      growth += std::max<std::size_t>(inodes.capacity(), 1) * sizeof(Inode) +
+                Node::kHeapBlockOverhead;
+    }
+
+    ChargeMemory(MemoryCategory::kNodes, growth);
+    try {
+      node.Put(old_key, new_key, value, pgid, flags);
+    } catch (...) {
+      ReleaseMemory(MemoryCategory::kNodes, growth);
+      throw;
+    }
+    Settle(e, e.bytes + growth);
+
+    SpillExcept(id);
+  }
+
+  /// Node::Del() on node `id`.
+  void Del(Id id, std::span<const std::byte> key) {
+    auto& e = Use(id);
+    e.node->Del(key);
+    Settle(e, e.bytes);
+
+    SpillExcept(id);
+  }
+
+  /// Removes node `id` and returns it, e.g. to write it out at commit.
+  Node Release(Id id) {
+    auto it = entries_.find(id);
+    assert(it != entries_.end());
+    auto& e = it->second;
+    if (!e.node) Reload(id, e);
+
+    auto node = std::move(*e.node);
+    bytes_ -= e.bytes;
+    ReleaseMemory(MemoryCategory::kNodes, e.bytes);
+    lru_.erase(e.lru);
+    entries_.erase(it);
+
+    return node;
+  }
+
+  /// Ids of every node held, in no particular order.
+  [[nodiscard]] std::vector<Id> Ids() const {
+    std::vector<Id> ids;
+    ids.reserve(entries_.size());
+    for (const auto& [id, e] : entries_) ids.push_back(id);
+
+    return ids;
+  }
+
+  [[nodiscard]] bool IsSpilled(Id id) const { return !entries_.at(id).node; }
+
+  /// Number of nodes held, in memory or spilled.
+  [[nodiscard]] std::size_t Count() const noexcept { return entries_.size(); }
+
+  /// Heap bytes of the nodes in memory.
+  [[nodiscard]] std::size_t Bytes() const noexcept { return bytes_; }
+
+  /// Pages currently holding spilled nodes.
+  [[nodiscard]] std::size_t SpilledPages() const noexcept {
+    return spilled_pages_;
+  }
+
+  /// Frees every spill page and drops every node. If `free` throws, the
+  /// other pages are still freed and every node dropped before the first
+  /// exception is rethrown.
+  void Rollback() {
+    std::exception_ptr error;
+    for (auto& [id, e] : entries_) {
+      if (e.pages > 0) {
+        try {
+          pages_.free(e.spill, e.pages);
+        } catch (...) {
+          if (!error) error = std::current_exception();
+        }
+      }
+      ReleaseMemory(MemoryCategory::kKeys, e.key.size());
+    }
+    ReleaseMemory(MemoryCategory::kNodes, bytes_);
+    entries_.clear();
+    lru_.clear();
+    bytes_ = 0;
+    spilled_pages_ = 0;
+
+    if (error) std::rethrow_exception(error);
+  }
+
+ private:
+  struct Entry {
+    std::optional<Node> node;  // Empty while spilled.
+    std::size_t bytes = 0;
+    std::list<Id>::iterator lru;
+
+    // State of a spilled node that its page does not hold.
+    PageId spill{};
+    std::size_t pages = 0;
+    std::vector<std::byte> key;
+    bool unbalanced = false;
+    InsertPatternTracker* tracker = nullptr;
+  };
+
+  /// Makes node `id` resident and the most recently used.
+  Entry& Use(Id id) {
+    auto& e = entries_.at(id);
+    if (e.node) {
+      lru_.splice(lru_.begin(), lru_, e.lru);
+    } else {
+      Reload(id, e);
+    }
+
+    return e;
+  }
+
+  /// Re-measures a changed node, `charged` bytes of which the tracker
+  /// already holds, and settles the difference.
+  void Settle(Entry& e, std::size_t charged) {
+    const auto bytes = e.node->MemoryUsage();
+    if (bytes > charged) {
+      AccountMemory(MemoryCategory::kNodes, bytes - charged);
+    } else {
+      ReleaseMemory(MemoryCategory::kNodes, charged - bytes);
+    }
+    bytes_ = bytes_ - e.bytes + bytes;
+    e.bytes = bytes;
+  }
+
+  void ChargeMemory(MemoryCategory category, std::size_t bytes) {
+    if (tracker_ != nullptr) tracker_->Charge(category, bytes);
+  }
+
+  void AccountMemory(MemoryCategory category, std::size_t bytes) {
+    if (tracker_ != nullptr) tracker_->Account(category, bytes);
+  }
+
+  void ReleaseMemory(MemoryCategory category, std::size_t bytes) {
+    if (tracker_ != nullptr) tracker_->Release(category, bytes);
+  }
+
+  /// Spills the coldest nodes, other than `keep`, until within budget.
+  void SpillExcept(Id keep) {
+    while (bytes_ > options_.budget && !lru_.empty() && lru_.back() != keep) {
+      const auto id = lru_.back();
+      Spill(entries_.at(id));
+    }
+  }
+
+  void Spill(Entry& e) {
+    const auto& node = *e.node;
+    const auto pages =
+        (node.Size() + options_.page_size - 1) / options_.page_size;
+
+    std::vector<std::byte> buf(pages * options_.page_size);
+    auto* p = reinterpret_cast<Page*>(buf.data());
+    p->id = node.Pgid();
+    p->overflow = static_cast<std::uint32_t>(pages - 1);
+    node.Write(*p);
+    std::vector<std::byte> key(node.Key().begin(), node.Key().end());
+
+    // Nothing is accounted until the pages are held, so a failed
+    // allocation has nothing to undo.
+    const auto spill = pages_.allocate(pages);
+    AccountMemory(MemoryCategory::kPages, buf.size());
+    try {
+      file_.WriteAt(buf, ToUint64(spill) * options_.page_size);
+    } catch (...) {
+      pages_.free(spill, pages);
+      ReleaseMemory(MemoryCategory::kPages, buf.size());
+      throw;
+    }
+    ReleaseMemory(MemoryCategory::kPages, buf.size());
+
+    e.spill = spill;
+    e.pages = pages;
+    e.key = std::move(key);
+    AccountMemory(MemoryCategory::kKeys, e.key.size());
+    e.unbalanced = node.IsUnbalanced();
+    e.tracker = node.GetInsertPatternTracker();
+    e.node.reset();
+    bytes_ -= e.bytes;
+    ReleaseMemory(MemoryCategory::kNodes, e.bytes);
+    spilled_pages_ += pages;
+    lru_.erase(e.lru);
+  }
+
+  void Reload(Id id, Entry& e) {
+    const auto offset = ToUint64(e.spill) * options_.page_size;
+    std::vector<std::byte> buf(e.pages * options_.page_size);
+    ChargeMemory(MemoryCategory::kPages, buf.size());
+    Node node;
+    try {
+      if (!file_.ReadAt(buf, offset)) ThrowError(Errc::kPageOutOfRange);
+      node.ReadSpilled(*reinterpret_cast<const Page*>(buf.data()), e.key,
+                       e.unbalanced);
+      ChargeMemory(MemoryCategory::kNodes, node.MemoryUsage());
+    } catch (...) {
+      ReleaseMemory(MemoryCategory::kPages, buf.size());
+      throw;
+    }
+    ReleaseMemory(MemoryCategory::kPages, buf.size());
+    node.SetInsertPatternTracker(e.tracker);
+
+    pages_.free(e.spill, e.pages);
+    spilled_pages_ -= e.pages;
+    e.pages = 0;
+    ReleaseMemory(MemoryCategory::kKeys, e.key.size());
+    e.key.clear();
+    e.bytes = node.MemoryUsage();
+    e.node.emplace(std::move(node));
+    bytes_ += e.bytes;
+    lru_.push_front(id);
+    e.lru = lru_.begin();
+  }
+
+  File& file_;
+  SpillPages pages_;
+  SpillOptions options_;
+  MemoryTracker* tracker_;
+  std::unordered_map<Id, Entry> entries_;
+  std::list<Id> lru_;  // Nodes in memory, most recently used first.
+  Id next_ = 1;
+  std::size_t bytes_ = 0;
+  std::size_t spilled_pages_ = 0;
+};
+
+}  // namespace boltdb
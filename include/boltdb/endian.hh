@@ -0,0 +1,67 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+namespace boltdb {
+
+// Byte-order helpers for on-page integers. Written as plain shift loops so
+// they are independent of the host byte order; compilers lower them to a
+// single load (plus bswap where needed).
+
+inline std::uint64_t LoadBigEndian64(const std::byte* p) noexcept {
+  std::uint64_t v = 0;
+  for (int i = 0; i < 8; ++i) {
+    v = (v << 8) | std::to_integer<std::uint64_t>(p[i]);
+  }
+
+  return v;
+}
+
+inline void StoreBigEndian64(std::byte* p, std::uint64_t v) noexcept {
+  for (int i = 7; i >= 0; --i) {
+    p[i] = static_cast<std::byte>(v & 0xFF);
+    v >>= 8;
+  }
+}
+
+inline std::uint64_t LoadLittleEndian64(const std::byte* p) noexcept {
+  std::uint64_t v = 0;
+  for (int i = 7; i >= 0; --i) {
+    v = (v << 8) | std::to_integer<std::uint64_t>(p[i]);
+  }
+
+  return v;
+}
+
+inline void StoreLittleEndian64(std::byte* p, std::uint64_t v) noexcept {
+  for (int i = 0; i < 8; ++i) {
+    p[i] = static_cast<std::byte>(v & 0xFF);
+    v >>= 8;
+  }
+}
+
+inline std::uint32_t LoadLittleEndian32(const std::byte* p) noexcept {
+  std::uint32_t v = 0;
+  for (int i = 3; i >= 0; --i) {
+    v = (v << 8) | std::to_integer<std::uint32_t>(p[i]);
+  }
+
+  return v;
+}
+
+inline void StoreLittleEndian32(std::byte* p, std::uint32_t v) noexcept {
+  for (int i = 0; i < 4; ++i) {
+    p[i] = static_cast<std::byte>(v & 0xFF);
+    v >>= 8;
+  }
+}
+
+/// Decode an 8-byte big-endian key. The caller must ensure `key` is exactly
+/// eight bytes long.
+inline std::uint64_t KeyToUint64(std::span<const std::byte> key) noexcept {
+  return LoadBigEndian64(key.data());
+}
+
+}  // namespace boltdb
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+namespace boltdb {
+
+/// \brief Errc enumerates the errors reported by boltdb, mirroring the Err*
+///        values of the Go version. They are thrown as std::system_error in
+///        boltdb's error category.
+enum class Errc {
+  kKeyRequired = 1,      ///< A zero-length key was given.
+  kKeyTooLarge,          ///< The key is longer than kMaxKeySize.
+  kValueTooLarge,        ///< The value is longer than kMaxValueSize.
+  kValueSizeMismatch,    ///< A streamed value differs from its declared size.
+  kChecksumMismatch,     ///< Stored data does not match its checksum.
+  kIncompatibleValue,    ///< The operation does not apply to the key's value.
+  kInvalidKey,           ///< An encryption key has an unsupported length.
+  kDecryptionFailed,     ///< Encrypted data failed authentication.
+  kPageOutOfRange,       ///< A page lies past the end of the file.
+  kPoolExhausted,        ///< Every page in the buffer pool is pinned.
+  kMemoryLimitExceeded,  ///< A transaction would exceed its memory limit.
+  kUnsupportedPage,      ///< The page's format cannot be read this way.
+  kCipherFailed,         ///< The crypto library reported an error.
+};
+
+namespace detail {
+
+class ErrorCategory final : public std::error_category {
+ public:
+  [[nodiscard]] const char* name() const noexcept override { return "boltdb"; }
+
+  [[nodiscard]] std::string message(int ev) const override {
+    switch (static_cast<Errc>(ev)) {
+      case Errc::kKeyRequired:
+        return "key required";
+      case Errc::kKeyTooLarge:
+        return "key too large";
+      case Errc::kValueTooLarge:
+        return "value too large";
+      case Errc::kValueSizeMismatch:
+        return "value size does not match the declared size";
+      case Errc::kChecksumMismatch:
+        return "checksum mismatch";
+      case Errc::kIncompatibleValue:
+        return "incompatible value";
+      case Errc::kInvalidKey:
+        return "invalid encryption key";
+      case Errc::kDecryptionFailed:
+        return "decryption failed";
+      case Errc::kPageOutOfRange:
+        return "page out of range";
+      case Errc::kPoolExhausted:
+        return "buffer pool exhausted";
+      case Errc::kMemoryLimitExceeded:
+        return "memory limit exceeded";
+      case Errc::kUnsupportedPage:
+        return "unsupported page format";
+      case Errc::kCipherFailed:
+        return "cipher failed";
+    }
+
+    return "unknown error";
+  }
+};
+
+}  // namespace detail
+
+/// The error category of boltdb errors.
+inline const std::error_category& ErrorCategory() noexcept {
+  static const detail::ErrorCategory category;
+  return category;
+}
+
+inline std::error_code make_error_code(Errc e) noexcept {
+  return {static_cast<int>(e), ErrorCategory()};
+}
+
+/// Throws `e` as a std::system_error.
+[[noreturn]] inline void ThrowError(Errc e) {
+  throw std::system_error(make_error_code(e));
+}
+
+}  // namespace boltdb
+
+template <>
+struct std::is_error_code_enum<boltdb::Errc> : std::true_type {};
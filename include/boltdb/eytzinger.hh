@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <vector>
+
+#include "boltdb/node.hh"
+#include "boltdb/page.hh"
+#include "boltdb/search.hh"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define BOLTDB_PREFETCH(addr) __builtin_prefetch(addr)
+#else
+#define BOLTDB_PREFETCH(addr) ((void)(addr))
+#endif
+
+namespace boltdb {
+
+/// A branch page flagged kSearchIndex carries, between its BranchElement
+/// array and the key data, the first 8 bytes of every separator key laid
+/// out in Eytzinger (BFS) order, plus the sorted rank of each slot:
+///
+/// ┌────────────────────────────────────────────────────────────────────┐
+/// │ Page Header │ BranchElement[n] │ u64 heads[n + 1] │ u16 ranks[n + 1] │
+/// │ … pad │ keys …                                                       │
+/// └────────────────────────────────────────────────────────────────────┘
+///
+/// Heads are taken after the prefix shared by all separators, whose length
+/// is kept in slot 0; the children of slot k are 2k and 2k + 1. Descending
+/// that implicit tree is a branchless loop over one small contiguous array
+/// whose next cache lines can be prefetched, instead of a binary search
+/// that dereferences a separator key at every step. The BranchElement
+/// array is kept unchanged, so readers unaware of the index still work and
+/// separators sharing their first 8 bytes are resolved by exact compare.
+
+/// Bytes used by the search index of a branch page with `count` elements.
+constexpr std::size_t SearchIndexSize(std::size_t count) noexcept {
+  const auto heads = (count + 1) * sizeof(std::uint64_t);
+  const auto ranks = (count + 1) * sizeof(std::uint16_t);
+
+  return heads + ((ranks + 7) & ~std::size_t{7});
+}
+
+namespace detail {
+
+inline std::uint64_t* SearchIndexHeads(Page& p) {
+  return reinterpret_cast<std::uint64_t*>(p.DataPtr() +
+                                          p.count * kBranchElementSize);
+}
+
+inline const std::uint64_t* SearchIndexHeads(const Page& p) {
+  return reinterpret_cast<const std::uint64_t*>(p.DataPtr() +
+                                                p.count * kBranchElementSize);
+}
+
+inline const std::uint16_t* SearchIndexRanks(const Page& p) {
+  return reinterpret_cast<const std::uint16_t*>(SearchIndexHeads(p) +
+                                                p.count + 1);
+}
+
+/// Places sorted[rank] into the Eytzinger slots below `k` (in-order walk).
+inline void EytzingerFill(std::span<const std::uint64_t> sorted,
+                          std::size_t& rank, std::size_t k,
+                          std::uint64_t* heads, std::uint16_t* ranks) {
+  if (k > sorted.size()) return;
+
+  EytzingerFill(sorted, rank, 2 * k, heads, ranks);
+  heads[k] = sorted[rank];
+  ranks[k] = static_cast<std::uint16_t>(rank);
+  ++rank;
+  EytzingerFill(sorted, rank, 2 * k + 1, heads, ranks);
+}
+
+}  // namespace detail
+
+/// Writes a branch node onto `p` with a search index. The page must be at
+/// least `n.Size() + SearchIndexSize(n.Count())` bytes.
+inline void WriteIndexedBranch(const Node& n, Page& p) {
+  assert(!n.IsLeaf());
+
+  n.Write(p, SearchIndexSize(n.Count()));
+  p.flags = PageFlag::kBranch | PageFlag::kSearchIndex;
+
+  auto* heads = detail::SearchIndexHeads(p);
+  auto* ranks = reinterpret_cast<std::uint16_t*>(heads + p.count + 1);
+  std::memset(heads, 0, SearchIndexSize(p.count));
+  if (p.count == 0) return;
+
+  const auto elems = p.BranchElements();
+  const auto skip =
+      detail::CommonPrefix(elems.front().Key(), elems.back().Key());
+
+  std::vector<std::uint64_t> sorted;
+  sorted.reserve(p.count);
+  for (const auto& elem : elems) {
+    sorted.push_back(detail::KeyHead(elem.Key(), skip));
+  }
+
+  std::size_t rank = 0;
+  heads[0] = skip;
+  detail::EytzingerFill(sorted, rank, 1, heads, ranks);
+}
+
+/// Index of the branch element whose child covers `key`, using the page's
+/// search index. Equivalent to SearchBranch() on the same page.
+inline std::size_t SearchIndexedBranch(const Page& p,
+                                       std::span<const std::byte> key) {
+  assert(p.IsBranch() && p.HasSearchIndex());
+
+  const std::size_t n = p.count;
+  if (n == 0) return 0;
+
+  const auto* heads = detail::SearchIndexHeads(p);
+  const auto elems = p.BranchElements();
+
+  // Keys outside the shared prefix go to the first or last child.
+  const auto skip = static_cast<std::size_t>(heads[0]);
+  if (skip > 0) {
+    const auto prefix = elems.front().Key().first(skip);
+    const auto cmp = CompareKeys(key.first(std::min(skip, key.size())), prefix);
+    if (cmp < 0) return 0;
+    if (cmp > 0) return n - 1;
+  }
+  const auto head = detail::KeyHead(key, skip);
+
+  // Find the first slot whose head is not less than the key's head. Each
+  // step prefetches the great-grandchildren, 8 slots = one cache line.
+  std::size_t k = 1;
+  while (k <= n) {
+    BOLTDB_PREFETCH(heads + 8 * k);
+    k = 2 * k + (heads[k] < head);
+  }
+  k >>= std::countr_one(k) + 1;
+
+  // No separator head reaches the key's: the last child covers it.
+  if (k == 0) return n - 1;
+
+  // Every element before `rank` is smaller than the key. A strictly larger
+  // head settles it; equal heads need the exact compare.
+  std::size_t rank = detail::SearchIndexRanks(p)[k];
+  if (heads[k] == head) {
+    rank = static_cast<std::size_t>(
+        std::partition_point(elems.begin() + rank, elems.end(),
+                             [&](const BranchElement& e) {
+                               return CompareKeys(e.Key(), key) <= 0;
+                             }) -
+        elems.begin());
+  }
+
+  return rank > 0 ? rank - 1 : 0;
+}
+
+/// SearchBranch() for a whole page, using the search index when present.
+inline std::size_t SearchBranch(const Page& p, std::span<const std::byte> key,
+                                KeySearch mode) {
+  if (p.HasSearchIndex()) return SearchIndexedBranch(p, key);
+
+  return SearchBranch(p.BranchElements(), key, mode);
+}
+
+}  // namespace boltdb
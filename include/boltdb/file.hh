@@ -0,0 +1,120 @@
+#pragma once
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+#include <system_error>
+#include <utility>
+
+namespace boltdb {
+
+/// \brief File is a thin owner of a POSIX file descriptor with positional
+///        reads and writes. Failures throw std::system_error carrying errno.
+class File {
+ public:
+  File() = default;
+
+  /// Opens `path` with open(2) `flags`, creating it with `mode` if asked.
+  File(const std::filesystem::path& path, int flags, mode_t mode = 0644)
+      : fd_(::open(path.c_str(), flags | O_CLOEXEC, mode)) {
+    if (fd_ < 0) ThrowErrno("open");
+  }
+
+  File(File&& other) noexcept : fd_(std::exchange(other.fd_, -1)) {}
+
+  File& operator=(File&& other) noexcept {
+    if (this != &other) {
+      Close();
+      fd_ = std::exchange(other.fd_, -1);
+    }
+
+    return *this;
+  }
+
+  File(const File&) = delete;
+  File& operator=(const File&) = delete;
+
+  ~File() { Close(); }
+
+  [[nodiscard]] bool IsOpen() const noexcept { return fd_ >= 0; }
+  [[nodiscard]] int Fd() const noexcept { return fd_; }
+
+  /// Reads exactly `buf.size()` bytes at `offset`. Returns false if the
+  /// file ends first.
+  bool ReadAt(std::span<std::byte> buf, std::uint64_t offset) const {
+    while (!buf.empty()) {
+      const auto n = ::pread(fd_, buf.data(), buf.size(),
+                             static_cast<off_t>(offset));
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        ThrowErrno("pread");
+      }
+      if (n == 0) return false;
+
+      buf = buf.subspan(static_cast<std::size_t>(n));
+      offset += static_cast<std::uint64_t>(n);
+    }
+
+    return true;
+  }
+
+  /// Writes all of `buf` at `offset`.
+  void WriteAt(std::span<const std::byte> buf, std::uint64_t offset) {
+    while (!buf.empty()) {
+      const auto n = ::pwrite(fd_, buf.data(), buf.size(),
+                              static_cast<off_t>(offset));
+      if (n < 0) {
+        if (errno == EINTR) continue;
+        ThrowErrno("pwrite");
+      }
+
+      buf = buf.subspan(static_cast<std::size_t>(n));
+      offset += static_cast<std::uint64_t>(n);
+    }
+  }
+
+  [[nodiscard]] std::uint64_t Size() const {
+    struct stat st {};
+    if (::fstat(fd_, &st) != 0) ThrowErrno("fstat");
+
+    return static_cast<std::uint64_t>(st.st_size);
+  }
+
+  void Truncate(std::uint64_t size) {
+    if (::ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+      ThrowErrno("ftruncate");
+    }
+  }
+
+  /// Flushes the file's data to stable storage.
+  void Sync() {
+    if (::fdatasync(fd_) != 0) ThrowErrno("fdatasync");
+  }
+
+  void Close() noexcept {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+  }
+
+  /// Flushes directory `dir`, e.g. so a file renamed into it survives a
+  /// crash.
+  static void SyncDirectory(const std::filesystem::path& dir) {
+    File d(dir, O_RDONLY | O_DIRECTORY);
+    if (::fsync(d.fd_) != 0) ThrowErrno("fsync");
+  }
+
+ private:
+  [[noreturn]] static void ThrowErrno(const char* what) {
+    throw std::system_error(errno, std::generic_category(), what);
+  }
+
+  int fd_ = -1;
+};
+
+}  // namespace boltdb
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "boltdb/endian.hh"
+
+namespace boltdb {
+
+// ====================================================================
+// XXH64
+// ====================================================================
+
+namespace detail {
+
+inline constexpr std::uint64_t kPrime64_1 = 0x9E3779B185EBCA87ULL;
+inline constexpr std::uint64_t kPrime64_2 = 0xC2B2AE3D27D4EB4FULL;
+inline constexpr std::uint64_t kPrime64_3 = 0x165667B19E3779F9ULL;
+inline constexpr std::uint64_t kPrime64_4 = 0x85EBCA77C2B2AE63ULL;
+inline constexpr std::uint64_t kPrime64_5 = 0x27D4EB2F165667C5ULL;
+
+constexpr std::uint64_t XXH64Round(std::uint64_t acc,
+                                   std::uint64_t input) noexcept {
+  acc += input * kPrime64_2;
+  acc = std::rotl(acc, 31);
+  return acc * kPrime64_1;
+}
+
+constexpr std::uint64_t XXH64MergeRound(std::uint64_t acc,
+                                        std::uint64_t val) noexcept {
+  acc ^= XXH64Round(0, val);
+  return acc * kPrime64_1 + kPrime64_4;
+}
+
+}  // namespace detail
+
+/// XXH64 of `data`. Used wherever keys or values need a fast, well-mixed
+/// 64-bit hash (hash buckets, the adaptive hash index, checksums).
+inline std::uint64_t HashBytes(std::span<const std::byte> data,
+                               std::uint64_t seed = 0) noexcept {
+  using namespace detail;
+
+  const std::byte* p = data.data();
+  const std::byte* const end = p + data.size();
+  std::uint64_t h;
+
+  if (data.size() >= 32) {
+    std::uint64_t v1 = seed + kPrime64_1 + kPrime64_2;
+    std::uint64_t v2 = seed + kPrime64_2;
+    std::uint64_t v3 = seed;
+    std::uint64_t v4 = seed - kPrime64_1;
+
+    for (; end - p >= 32; p += 32) {
+      v1 = XXH64Round(v1, LoadLittleEndian64(p));
+      v2 = XXH64Round(v2, LoadLittleEndian64(p + 8));
+      v3 = XXH64Round(v3, LoadLittleEndian64(p + 16));
+      v4 = XXH64Round(v4, LoadLittleEndian64(p + 24));
+    }
+
+    h = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) +
+        std::rotl(v4, 18);
+    h = XXH64MergeRound(h, v1);
+    h = XXH64MergeRound(h, v2);
+    h = XXH64MergeRound(h, v3);
+    h = XXH64MergeRound(h, v4);
+  } else {
+    h = seed + kPrime64_5;
+  }
+
+  h += data.size();
+
+  for (; end - p >= 8; p += 8) {
+    h ^= XXH64Round(0, LoadLittleEndian64(p));
+    h = std::rotl(h, 27) * kPrime64_1 + kPrime64_4;
+  }
+
+  if (end - p >= 4) {
+    h ^= static_cast<std::uint64_t>(LoadLittleEndian32(p)) * kPrime64_1;
+    h = std::rotl(h, 23) * kPrime64_2 + kPrime64_3;
+    p += 4;
+  }
+
+  for (; p < end; ++p) {
+    h ^= std::to_integer<std::uint64_t>(*p) * kPrime64_5;
+    h = std::rotl(h, 11) * kPrime64_1;
+  }
+
+  h ^= h >> 33;
+  h *= kPrime64_2;
+  h ^= h >> 29;
+  h *= kPrime64_3;
+  h ^= h >> 32;
+
+  return h;
+}
+
+/// A 128-bit hash value.
+struct Hash128 {
+  std::uint64_t hi = 0;
+  std::uint64_t lo = 0;
+
+  bool operator==(const Hash128&) const = default;
+};
+
+/// 128-bit hash of `data` from two independently seeded XXH64 runs. Fast
+/// and well distributed enough to name content, but not collision
+/// resistant: callers that must not confuse values compare them too.
+inline Hash128 HashBytes128(std::span<const std::byte> data) noexcept {
+  return Hash128{HashBytes(data, 0), HashBytes(data, detail::kPrime64_3)};
+}
+
+}  // namespace boltdb
@@ -0,0 +1,198 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "boltdb/hash.hh"
+#include "boltdb/node.hh"
+#include "boltdb/page.hh"
+
+namespace boltdb {
+
+/// An extendible-hash bucket trades range scans for O(1) page touches per
+/// lookup. Its BucketHeader is stored under a LeafElement flagged
+/// LeafFlag::kHashBucket and points at a directory page:
+///
+/// ┌──────────────────────────────────────────────────────────────┐
+/// │ Page Header │ global_depth │ PageId slots[n] │ u8 depths[n]  │
+/// └──────────────────────────────────────────────────────────────┘
+///
+/// Slot `hash & (n - 1)` names the hash bucket page holding the key. Hash
+/// bucket pages use the regular leaf layout (sorted LeafElements) with the
+/// kHashBucket flag, so they are read and written through Node.
+///
+/// The directory is copy-on-write like every other page: a split or a
+/// relocated bucket page produces a new directory page in the same
+/// transaction, and readers keep using the directory their meta points to.
+inline constexpr std::uint32_t kMaxHashGlobalDepth = 24;
+
+class HashDirectory {
+ public:
+  HashDirectory() = default;
+
+  /// A directory of depth zero with a single bucket page.
+  explicit HashDirectory(PageId first) : slots_{first}, depths_{0} {}
+
+  [[nodiscard]] std::uint32_t GlobalDepth() const noexcept {
+    return global_depth_;
+  }
+
+  [[nodiscard]] std::size_t SlotCount() const noexcept { return slots_.size(); }
+
+  [[nodiscard]] std::size_t SlotFor(std::uint64_t hash) const noexcept {
+    return static_cast<std::size_t>(hash & (slots_.size() - 1));
+  }
+
+  /// Bucket page holding keys with the given hash.
+  [[nodiscard]] PageId Lookup(std::uint64_t hash) const noexcept {
+    assert(!slots_.empty());
+    return slots_[SlotFor(hash)];
+  }
+
+  [[nodiscard]] PageId SlotPage(std::size_t slot) const {
+    return slots_[slot];
+  }
+
+  [[nodiscard]] std::uint8_t LocalDepth(std::size_t slot) const {
+    return depths_[slot];
+  }
+
+  /// Returns false once the bucket at `slot` can no longer be split because
+  /// the directory has reached kMaxHashGlobalDepth. Such a bucket keeps
+  /// growing into overflow pages instead.
+  [[nodiscard]] bool CanSplit(std::size_t slot) const {
+    return depths_[slot] < global_depth_ || global_depth_ < kMaxHashGlobalDepth;
+  }
+
+  /// Splits the bucket at `slot`. Keys whose hash has bit `LocalDepth(slot)`
+  /// set move to `new_pgid`; the directory doubles first if the bucket was
+  /// already at the global depth.
+  void Split(std::size_t slot, PageId new_pgid) {
+    assert(CanSplit(slot));
+
+    const auto depth = depths_[slot];
+    const auto old_pgid = slots_[slot];
+
+    if (depth == global_depth_) {
+      const auto n = slots_.size();
+      slots_.resize(n * 2);
+      depths_.resize(n * 2);
+      std::copy_n(slots_.begin(), n, slots_.begin() + n);
+      std::copy_n(depths_.begin(), n, depths_.begin() + n);
+      ++global_depth_;
+    }
+
+    for (std::size_t i = 0; i < slots_.size(); ++i) {
+      if (slots_[i] != old_pgid) continue;
+
+      depths_[i] = depth + 1;
+      if ((i >> depth) & 1) slots_[i] = new_pgid;
+    }
+  }
+
+  /// Points every slot referencing `from` at `to`, after a bucket page was
+  /// rewritten to a newly allocated page.
+  void Relocate(PageId from, PageId to) {
+    std::replace(slots_.begin(), slots_.end(), from, to);
+  }
+
+  /// Distinct bucket pages, e.g. to free them when the bucket is deleted.
+  [[nodiscard]] PageIds BucketPages() const {
+    PageIds ids(slots_.begin(), slots_.end());
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+
+    return ids;
+  }
+
+  /// Size of the directory after serialization.
+  [[nodiscard]] std::size_t Size() const noexcept {
+    return Page::kHeaderSize + kHeaderSize +
+           slots_.size() * (sizeof(PageId) + sizeof(std::uint8_t));
+  }
+
+  void Write(Page& p) const {
+    p.flags = PageFlag::kHashDirectory;
+    p.count = 0;
+
+    std::byte* data = p.DataPtr();
+    const std::uint64_t depth = global_depth_;
+    std::memcpy(data, &depth, sizeof(depth));
+    std::memcpy(data + kHeaderSize, slots_.data(),
+                slots_.size() * sizeof(PageId));
+    std::memcpy(data + kHeaderSize + slots_.size() * sizeof(PageId),
+                depths_.data(), depths_.size());
+  }
+
+  void Read(const Page& p) {
+    assert(p.IsHashDirectory());
+
+    const std::byte* data = p.DataPtr();
+    std::uint64_t depth;
+    std::memcpy(&depth, data, sizeof(depth));
+    assert(depth <= kMaxHashGlobalDepth);
+
+    global_depth_ = static_cast<std::uint32_t>(depth);
+    const std::size_t n = std::size_t{1} << global_depth_;
+    slots_.resize(n);
+    depths_.resize(n);
+    std::memcpy(slots_.data(), data + kHeaderSize, n * sizeof(PageId));
+    std::memcpy(depths_.data(), data + kHeaderSize + n * sizeof(PageId), n);
+  }
+
+ private:
+  /// The global depth, padded so the slots stay 8-byte aligned.
+  static constexpr std::size_t kHeaderSize = sizeof(std::uint64_t);
+
+  std::uint32_t global_depth_ = 0;
+  std::vector<PageId> slots_;
+  std::vector<std::uint8_t> depths_;
+};
+
+/// Hash used to place keys in a hash bucket.
+inline std::uint64_t HashBucketKey(std::span<const std::byte> key) noexcept {
+  return HashBytes(key);
+}
+
+/// Moves the keys of `node`, a hash bucket at local depth `depth`, that
+/// belong in its new sibling after HashDirectory::Split().
+[[nodiscard]] inline Node SplitHashBucket(Node& node, std::uint8_t depth) {
+  return node.Extract([depth](const Inode& inode) {
+    return ((HashBucketKey(inode.Key()) >> depth) & 1) != 0;
+  });
+}
+
+/// Writes `node` as a hash bucket page.
+inline void WriteHashBucket(const Node& node, Page& p) {
+  assert(node.IsLeaf());
+
+  node.Write(p);
+  p.flags = PageFlag::kHashBucket;
+}
+
+/// Looks up `key` in a hash bucket: one directory slot, one bucket page.
+/// Returns the value, or nothing if the key does not exist.
+[[nodiscard]] inline std::optional<std::span<const std::byte>> HashBucketGet(
+    const HashDirectory& dir, const PageResolver& resolve,
+    std::span<const std::byte> key) {
+  const Page* p = resolve(dir.Lookup(HashBucketKey(key)));
+  assert(p != nullptr && p->IsHashBucket());
+
+  const auto elems = p->LeafElements();
+  const auto it = std::partition_point(
+      elems.begin(), elems.end(),
+      [&](const LeafElement& e) { return CompareKeys(e.Key(), key) < 0; });
+  if (it == elems.end() || CompareKeys(it->Key(), key) != 0) {
+    return std::nullopt;
+  }
+
+  return it->Value();
+}
+
+}  // namespace boltdb
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include "boltdb/errors.hh"
+
+namespace boltdb {
+
+/// What tracked memory is held by.
+enum class MemoryCategory : std::uint8_t {
+  kNodes,  ///< Dirty nodes in memory: their inodes' key and value copies.
+  kPages,  ///< Page buffers, e.g. to write or read back a spilled node.
+  kKeys,   ///< Key copies held outside nodes.
+};
+
+inline constexpr std::size_t kMemoryCategories = 3;
+
+/// \brief MemoryTracker accounts for the memory a write transaction holds
+///        and enforces a hard limit on it.
+///
+/// Charge() fails with kMemoryLimitExceeded, leaving the usage unchanged,
+/// when the transaction would go over its limit, so an oversized Put fails
+/// alone instead of taking the process down. Account() records memory that
+/// is already held, e.g. a node measured after it was changed in place,
+/// and never fails; the next Charge() then sees the total.
+///
+/// A tracker may have a parent, e.g. one per DB or worker above one per
+/// transaction. Usage is charged to every ancestor and each one's limit is
+/// enforced. Counters are atomic so usage can be read from another thread
+/// while the transaction runs.
+class MemoryTracker {
+ public:
+  static constexpr std::size_t kUnlimited =
+      std::numeric_limits<std::size_t>::max();
+
+  explicit MemoryTracker(std::size_t limit = kUnlimited,
+                         MemoryTracker* parent = nullptr)
+      : limit_(limit), parent_(parent) {}
+
+  MemoryTracker(const MemoryTracker&) = delete;
+  MemoryTracker& operator=(const MemoryTracker&) = delete;
+
+  /// Returns what is still held to the parent.
+  ~MemoryTracker() {
+    if (parent_ != nullptr) {
+      for (std::size_t i = 0; i < kMemoryCategories; ++i) {
+        parent_->Release(static_cast<MemoryCategory>(i), Used(i));
+      }
+    }
+  }
+
+  /// Records `bytes` more held under `category`. Throws
+  /// kMemoryLimitExceeded, recording nothing, if this tracker or an
+  /// ancestor would go over its limit.
+  void Charge(MemoryCategory category, std::size_t bytes) {
+    const auto total = total_.fetch_add(bytes) + bytes;
+    if (total > limit_.load(std::memory_order_relaxed)) {
+      total_.fetch_sub(bytes);
+      ThrowError(Errc::kMemoryLimitExceeded);
+    }
+
+    if (parent_ != nullptr) {
+      try {
+        parent_->Charge(category, bytes);
+      } catch (...) {
+        total_.fetch_sub(bytes);
+        throw;
+      }
+    }
+
+    Slot(category).fetch_add(bytes, std::memory_order_relaxed);
+    UpdatePeak(total);
+  }
+
+  /// Records `bytes` more held under `category`, whatever the limit.
+  void Account(MemoryCategory category, std::size_t bytes) {
+    const auto total = total_.fetch_add(bytes) + bytes;
+    Slot(category).fetch_add(bytes, std::memory_order_relaxed);
+    UpdatePeak(total);
+    if (parent_ != nullptr) parent_->Account(category, bytes);
+  }
+
+  /// Records that `bytes` under `category` were freed.
+  void Release(MemoryCategory category, std::size_t bytes) {
+    total_.fetch_sub(bytes);
+    Slot(category).fetch_sub(bytes, std::memory_order_relaxed);
+    if (parent_ != nullptr) parent_->Release(category, bytes);
+  }
+
+  /// Bytes held under `category`.
+  [[nodiscard]] std::size_t Used(MemoryCategory category) const {
+    return Used(static_cast<std::size_t>(category));
+  }
+
+  /// Bytes held in total.
+  [[nodiscard]] std::size_t Total() const noexcept { return total_.load(); }
+
+  /// The highest Total() so far.
+  [[nodiscard]] std::size_t Peak() const noexcept {
+    return peak_.load(std::memory_order_relaxed);
+  }
+
+  [[nodiscard]] std::size_t Limit() const noexcept {
+    return limit_.load(std::memory_order_relaxed);
+  }
+
+  /// Changes the limit. Memory already held is kept even if over it.
+  void SetLimit(std::size_t limit) noexcept {
+    limit_.store(limit, std::memory_order_relaxed);
+  }
+
+ private:
+  std::atomic<std::size_t>& Slot(MemoryCategory category) {
+    return used_[static_cast<std::size_t>(category)];
+  }
+
+  [[nodiscard]] std::size_t Used(std::size_t i) const {
+    return used_[i].load(std::memory_order_relaxed);
+  }
+
+  void UpdatePeak(std::size_t total) {
+    auto peak = peak_.load(std::memory_order_relaxed);
+    while (total > peak &&
+           !peak_.compare_exchange_weak(peak, total,
+                                        std::memory_order_relaxed)) {
+    }
+  }
+
+  std::atomic<std::size_t> limit_;
+  MemoryTracker* parent_;
+  std::atomic<std::size_t> total_{0};
+  std::atomic<std::size_t> peak_{0};
+  std::array<std::atomic<std::size_t>, kMemoryCategories> used_{};
+};
+
+}  // namespace boltdb
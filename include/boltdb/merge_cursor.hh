@@ -0,0 +1,165 @@
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "boltdb/cursor.hh"
+
+namespace boltdb {
+
+/// An item from one of the sources of a MergeCursor.
+struct MergeEntry {
+  std::size_t source;  ///< Index of the cursor the item came from.
+  KeyValue kv;
+};
+
+/// Picks the entry to return when several sources hold the same key.
+/// `tied` is ordered by source index; the result indexes into it.
+using ConflictResolver =
+    std::function<std::size_t(std::span<const MergeEntry>)>;
+
+/// Keeps the entry of the lowest source, e.g. the newest snapshot first.
+inline std::size_t PreferFirstSource(std::span<const MergeEntry>) { return 0; }
+
+/// Keeps the entry of the highest source.
+inline std::size_t PreferLastSource(std::span<const MergeEntry> tied) {
+  return tied.size() - 1;
+}
+
+/// MergeCursor combines N cursors, e.g. on time-sharded buckets or
+/// sub-buckets, into one ordered stream.
+///
+/// A loser tree holds the current key of every source: after the winner is
+/// consumed only its path to the root is replayed, log2(N) comparisons
+/// with no heap allocation per item. Keys and values are views into the
+/// sources' pages, so nothing is copied.
+///
+/// When several sources hold the same key the ConflictResolver chooses the
+/// entry returned and the others are skipped. Without a resolver every
+/// duplicate is returned, in source order.
+class MergeCursor {
+ public:
+  explicit MergeCursor(std::vector<Cursor> sources,
+                       ConflictResolver resolve = PreferFirstSource)
+      : sources_(std::move(sources)),
+        resolve_(std::move(resolve)),
+        heads_(sources_.size()),
+        tree_(sources_.size()) {}
+
+  /// Moves every source to its first item and returns the smallest.
+  std::optional<KeyValue> First() {
+    for (std::size_t i = 0; i < sources_.size(); ++i) {
+      heads_[i] = sources_[i].First();
+    }
+    Build();
+
+    return Pop();
+  }
+
+  /// Moves every source to `key` and returns the smallest key not less than
+  /// it.
+  std::optional<KeyValue> Seek(std::span<const std::byte> key) {
+    for (std::size_t i = 0; i < sources_.size(); ++i) {
+      heads_[i] = sources_[i].Seek(key);
+    }
+    Build();
+
+    return Pop();
+  }
+
+  /// Returns the next item in key order, or nothing at the end.
+  std::optional<KeyValue> Next() { return Pop(); }
+
+  /// Source of the item returned last.
+  [[nodiscard]] std::size_t Source() const noexcept { return source_; }
+
+ private:
+  /// Returns true if the head of source `a` comes before that of `b`.
+  /// Exhausted sources sort last; ties go to the lower source.
+  [[nodiscard]] bool Beats(std::size_t a, std::size_t b) const {
+    if (!heads_[b]) return true;
+    if (!heads_[a]) return false;
+
+    const auto cmp = CompareKeys(heads_[a]->key, heads_[b]->key);
+    if (cmp != 0) return cmp < 0;
+
+    return a < b;
+  }
+
+  /// Plays the match at internal node `node` and returns its winner. Leaves
+  /// sit at [N, 2N); internal nodes keep the loser.
+  std::size_t Play(std::size_t node) {
+    const auto n = sources_.size();
+    if (node >= n) return node - n;
+
+    const auto left = Play(2 * node);
+    const auto right = Play(2 * node + 1);
+    if (Beats(left, right)) {
+      tree_[node] = right;
+      return left;
+    }
+    tree_[node] = left;
+
+    return right;
+  }
+
+  void Build() {
+    if (!sources_.empty()) tree_[0] = Play(1);
+  }
+
+  /// Re-runs the matches on the path of `source` after its head changed.
+  void Replay(std::size_t source) {
+    auto winner = source;
+    for (auto node = (source + sources_.size()) / 2; node >= 1; node /= 2) {
+      if (Beats(tree_[node], winner)) std::swap(tree_[node], winner);
+    }
+    tree_[0] = winner;
+  }
+
+  /// Removes the current head of the winning source and advances it.
+  MergeEntry Advance() {
+    const auto w = tree_[0];
+    MergeEntry entry{w, *heads_[w]};
+    heads_[w] = sources_[w].Next();
+    Replay(w);
+
+    return entry;
+  }
+
+  std::optional<KeyValue> Pop() {
+    if (sources_.empty() || !heads_[tree_[0]]) return std::nullopt;
+
+    auto entry = Advance();
+    if (!resolve_) {
+      source_ = entry.source;
+      return entry.kv;
+    }
+
+    // Collect every source holding the same key.
+    tied_.clear();
+    tied_.push_back(entry);
+    while (heads_[tree_[0]] &&
+           CompareKeys(heads_[tree_[0]]->key, entry.kv.key) == 0) {
+      tied_.push_back(Advance());
+    }
+
+    const auto& chosen = tied_[tied_.size() == 1 ? 0 : resolve_(tied_)];
+    source_ = chosen.source;
+
+    return chosen.kv;
+  }
+
+  std::vector<Cursor> sources_;
+  ConflictResolver resolve_;
+  std::vector<std::optional<KeyValue>> heads_;
+  std::vector<std::size_t> tree_;
+  std::vector<MergeEntry> tied_;
+  std::size_t source_ = 0;
+};
+
+}  // namespace boltdb
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "boltdb/endian.hh"
+#include "boltdb/errors.hh"
+#include "boltdb/node.hh"
+#include "boltdb/page.hh"
+
+namespace boltdb {
+
+/// Combines two values into one. It must be associative, so operands for a
+/// key can be folded together before the stored value is read; a missing
+/// stored value acts as the identity.
+using MergeFn = std::function<std::vector<std::byte>(
+    std::span<const std::byte> left, std::span<const std::byte> right)>;
+
+/// Adds two 8-byte big-endian unsigned counters, wrapping on overflow.
+/// Throws kIncompatibleValue for values of another size. Counters are
+/// big-endian like every built-in integer operand, so MergeMax() orders
+/// them numerically too.
+inline std::vector<std::byte> MergeAddU64(std::span<const std::byte> left,
+                                          std::span<const std::byte> right) {
+  if (left.size() != 8 || right.size() != 8) {
+    ThrowError(Errc::kIncompatibleValue);
+  }
+
+  std::vector<std::byte> out(8);
+  StoreBigEndian64(out.data(), LoadBigEndian64(left.data()) +
+                                   LoadBigEndian64(right.data()));
+
+  return out;
+}
+
+/// Keeps the larger value in byte order, which is numeric order for
+/// big-endian integers of one width.
+inline std::vector<std::byte> MergeMax(std::span<const std::byte> left,
+                                       std::span<const std::byte> right) {
+  const auto max = CompareKeys(left, right) < 0 ? right : left;
+
+  return {max.begin(), max.end()};
+}
+
+/// Concatenates the values.
+inline std::vector<std::byte> MergeAppend(std::span<const std::byte> left,
+                                          std::span<const std::byte> right) {
+  std::vector<std::byte> out;
+  out.reserve(left.size() + right.size());
+  out.insert(out.end(), left.begin(), left.end());
+  out.insert(out.end(), right.begin(), right.end());
+
+  return out;
+}
+
+/// \brief MergeOperators maps operator names to functions. A bucket records
+///        the name of its operator; "add-u64", "max" and "append" are
+///        always registered.
+class MergeOperators {
+ public:
+  MergeOperators() {
+    Register("add-u64", MergeAddU64);
+    Register("max", MergeMax);
+    Register("append", MergeAppend);
+  }
+
+  /// Adds or replaces the operator called `name`.
+  void Register(std::string name, MergeFn fn) {
+    assert(fn && "register: empty merge function");
+    ops_.insert_or_assign(std::move(name), std::move(fn));
+  }
+
+  /// Returns the operator called `name`, or null if there is none.
+  [[nodiscard]] const MergeFn* Find(std::string_view name) const {
+    const auto it = ops_.find(name);
+
+    return it == ops_.end() ? nullptr : &it->second;
+  }
+
+ private:
+  std::map<std::string, MergeFn, std::less<>> ops_;
+};
+
+/// An operand to merge into the value of `key`.
+struct MergeOperand {
+  std::span<const std::byte> key;
+  std::span<const std::byte> operand;
+};
+
+/// Applies a batch of merge operands to leaf node `n` in one pass. `batch`
+/// must be sorted by key; operands of the same key are folded in batch
+/// order before the node is touched, so each key is searched and written
+/// once however many increments it receives. Keys without a value take the
+/// folded operand.
+///
+/// A bucket applies a sorted batch leaf by leaf, handing each leaf the run
+/// of keys below its right neighbour's first key.
+inline void ApplyMerges(Node& n, std::span<const MergeOperand> batch,
+                        const MergeFn& merge) {
+  std::vector<std::span<const std::byte>> keys;
+  std::vector<std::vector<std::byte>> folded;
+
+  for (std::size_t i = 0; i < batch.size();) {
+    const auto key = batch[i].key;
+    auto value = std::vector<std::byte>(batch[i].operand.begin(),
+                                        batch[i].operand.end());
+    for (++i; i < batch.size() && CompareKeys(batch[i].key, key) == 0; ++i) {
+      value = merge(value, batch[i].operand);
+    }
+    assert((keys.empty() || CompareKeys(keys.back(), key) < 0) &&
+           "merge: batch not sorted");
+
+    keys.push_back(key);
+    folded.push_back(std::move(value));
+  }
+
+  n.UpdateSorted(keys, [&](std::size_t i, auto old) {
+    if (!old) return std::optional(std::move(folded[i]));
+
+    return std::optional(merge(*old, folded[i]));
+  });
+}
+
+}  // namespace boltdb
@@ -0,0 +1,729 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "boltdb/bucket.hh"
+#include "boltdb/errors.hh"
+#include "boltdb/page.hh"
+
+namespace boltdb {
+
+inline constexpr double kMinFillPercent = 0.1;
+inline constexpr double kMaxFillPercent = 1.0;
+inline constexpr double kDefaultFillPercent = 0.5;
+
+// ====================================================================
+// InsertPattern
+// ====================================================================
+
+/// \brief InsertPattern describes where new keys land relative to the keys
+///        already present in a bucket.
+enum class InsertPattern : std::uint8_t {
+  kUnknown,     ///< Not enough samples yet; use the bucket's fill percent.
+  kAscending,   ///< Keys are appended after the largest key.
+  kDescending,  ///< Keys are prepended before the smallest key.
+  kRandom,      ///< Keys land anywhere.
+};
+
+/// Tracks the insertion locality of a single bucket.
+///
+/// Every insert reports its position inside the node it landed in. Appends
+/// (position == count) and prepends (position == 0) are counted separately;
+/// the counters are halved once the window fills up so the classification
+/// follows workload changes instead of averaging over the bucket's lifetime.
+class InsertPatternTracker {
+ public:
+  /// Number of samples before halving the counters.
+  static constexpr std::uint32_t kWindow = 64;
+  /// Minimum number of samples before a pattern is reported.
+  static constexpr std::uint32_t kMinSamples = 16;
+
+  /// Record an insert at `index` into a node that held `count` keys.
+  void Record(std::size_t index, std::size_t count) noexcept {
+    assert(index <= count);
+
+    // Inserts into an empty node carry no direction.
+    if (count == 0) return;
+
+    if (index == count) {
+      ++ascending_;
+    } else if (index == 0) {
+      ++descending_;
+    }
+
+    if (++total_ >= kWindow) {
+      ascending_ /= 2;
+      descending_ /= 2;
+      total_ /= 2;
+    }
+  }
+
+  /// A direction wins when at least 3/4 of the recent inserts follow it.
+  [[nodiscard]] InsertPattern Pattern() const noexcept {
+    if (total_ < kMinSamples) return InsertPattern::kUnknown;
+    if (ascending_ * 4 >= total_ * 3) return InsertPattern::kAscending;
+    if (descending_ * 4 >= total_ * 3) return InsertPattern::kDescending;
+
+    return InsertPattern::kRandom;
+  }
+
+  void Reset() noexcept { ascending_ = descending_ = total_ = 0; }
+
+ private:
+  std::uint32_t ascending_ = 0;
+  std::uint32_t descending_ = 0;
+  std::uint32_t total_ = 0;
+};
+
+// ====================================================================
+// Node
+// ====================================================================
+
+/// Inode represents an internal node inside of a node. It can be used to
+/// point to elements in a page or point to an element which hasn't been
+/// added to a page yet.
+struct Inode {
+  LeafFlag flags = LeafFlag::kNone;
+  PageId pgid{};
+  std::vector<std::byte> key;
+  std::vector<std::byte> value;
+
+  [[nodiscard]] std::span<const std::byte> Key() const { return key; }
+  [[nodiscard]] std::span<const std::byte> Value() const { return value; }
+};
+
+using Inodes = std::vector<Inode>;
+
+/// Node represents an in-memory, deserialized page.
+class Node {
+ public:
+  Node() = default;
+  explicit Node(bool is_leaf) : is_leaf_(is_leaf) {}
+
+  [[nodiscard]] bool IsLeaf() const noexcept { return is_leaf_; }
+  [[nodiscard]] PageId Pgid() const noexcept { return pgid_; }
+  [[nodiscard]] std::span<const std::byte> Key() const { return key_; }
+  [[nodiscard]] const Inodes& GetInodes() const noexcept { return inodes_; }
+  [[nodiscard]] std::size_t Count() const noexcept { return inodes_.size(); }
+
+  /// Attach the owning bucket's insert pattern tracker. Puts report their
+  /// position to it and splits consult it to pick the split point.
+  void SetInsertPatternTracker(InsertPatternTracker* tracker) noexcept {
+    tracker_ = tracker;
+  }
+
+  [[nodiscard]] InsertPatternTracker* GetInsertPatternTracker() const noexcept {
+    return tracker_;
+  }
+
+  /// Minimum number of inodes this node should have.
+  [[nodiscard]] std::size_t MinKeys() const noexcept {
+    return is_leaf_ ? 1 : 2;
+  }
+
+  /// Size of a single element header for this node's page type.
+  [[nodiscard]] std::size_t PageElementSize() const noexcept {
+    return is_leaf_ ? kLeafElementSize : kBranchElementSize;
+  }
+
+  /// Size of the node after serialization.
+  [[nodiscard]] std::size_t Size() const noexcept {
+    std::size_t sz = Page::kHeaderSize;
+    const auto elsz = PageElementSize();
+
+    for (const auto& inode : inodes_) {
+      sz += elsz + inode.key.size() + inode.value.size();
+    }
+
+    return sz;
+  }
+
+  /// Bookkeeping a typical malloc keeps per block, e.g. glibc's chunk header
+  /// rounded to its 16-byte alignment.
+  static constexpr std::size_t kHeapBlockOverhead = 16;
+
+  /// Heap bytes the node holds: the inode array at its capacity and every
+  /// key and value buffer at theirs, each with an allocator's per-block
+  /// overhead. Unlike Size() this is what a memory limit should count.
+  [[nodiscard]] std::size_t MemoryUsage() const noexcept {
+    std::size_t sz = sizeof(Node) +
+                     HeapBlockSize(inodes_.capacity() * sizeof(Inode)) +
+                     HeapBlockSize(key_.capacity());
+
+    for (const auto& inode : inodes_) {
+      sz += HeapBlockSize(inode.key.capacity()) +
+            HeapBlockSize(inode.value.capacity());
+    }
+
+    return sz;
+  }
+
+  /// Returns true if the node is less than a given size. This is an
+  /// optimization to avoid calculating a large node when we only need to
+  /// know if it fits inside a certain page size.
+  [[nodiscard]] bool SizeLessThan(std::size_t v) const noexcept {
+    std::size_t sz = Page::kHeaderSize;
+    const auto elsz = PageElementSize();
+
+    for (const auto& inode : inodes_) {
+      sz += elsz + inode.key.size() + inode.value.size();
+      if (sz >= v) return false;
+    }
+
+    return true;
+  }
+
+  /// Index of the first inode whose key is not less than `key`.
+  [[nodiscard]] std::size_t LowerBound(std::span<const std::byte> key) const {
+    auto it = std::partition_point(
+        inodes_.begin(), inodes_.end(),
+        [&](const Inode& inode) { return CompareKeys(inode.Key(), key) < 0; });
+
+    return static_cast<std::size_t>(it - inodes_.begin());
+  }
+
+  /// Returns the inode stored under `key`, or null if there is none.
+  [[nodiscard]] const Inode* Find(std::span<const std::byte> key) const {
+    const auto index = LowerBound(key);
+    if (index >= inodes_.size() ||
+        CompareKeys(inodes_[index].Key(), key) != 0) {
+      return nullptr;
+    }
+
+    return &inodes_[index];
+  }
+
+  /// Inserts a key/value, replacing the inode stored under `old_key` if
+  /// there is one.
+  void Put(std::span<const std::byte> old_key,
+           std::span<const std::byte> new_key, std::span<const std::byte> value,
+           PageId pgid, LeafFlag flags) {
+    auto& inode = Upsert(old_key, new_key, pgid, flags);
+    inode.value.assign(value.begin(), value.end());
+  }
+
+  /// Put() taking ownership of an already materialized value, so large
+  /// values are moved into the node instead of copied.
+  void PutOwned(std::span<const std::byte> old_key,
+                std::span<const std::byte> new_key,
+                std::vector<std::byte>&& value, PageId pgid, LeafFlag flags) {
+    auto& inode = Upsert(old_key, new_key, pgid, flags);
+    inode.value = std::move(value);
+  }
+
+  /// Stores a `size`-byte value under `key` and returns it for the caller
+  /// to fill in place, so a serializer can write straight into the buffer
+  /// the node keeps instead of building the value and having Put() copy it.
+  /// The buffer starts zeroed. It stays valid until `key` is put or deleted
+  /// again, or the node is written. Throws kKeyRequired, kKeyTooLarge or
+  /// kValueTooLarge, and kIncompatibleValue if the key holds a sub-bucket;
+  /// the node is then unchanged.
+  std::span<std::byte> PutReserve(std::span<const std::byte> key,
+                                  std::size_t size) {
+    if (key.empty()) ThrowError(Errc::kKeyRequired);
+    if (key.size() > kMaxKeySize) ThrowError(Errc::kKeyTooLarge);
+    if (size > kMaxValueSize) ThrowError(Errc::kValueTooLarge);
+    if (const auto* old = Find(key);
+        old != nullptr && old->flags != LeafFlag::kNone) {
+      ThrowError(Errc::kIncompatibleValue);
+    }
+
+    auto& inode = Upsert(key, key, PageId{0}, LeafFlag::kNone);
+
+    // Drop the old value first so resize() doesn't copy it.
+    inode.value.clear();
+    inode.value.resize(size);
+
+    return inode.value;
+  }
+
+  /// Read-modify-write of `key` with a single search. `fn` receives the
+  /// current value, or nothing if the key is absent, as a view into the
+  /// node, and returns the new value, or nothing to delete the key. The
+  /// result is stored at the position found by the search. Throws
+  /// kIncompatibleValue if the key holds a sub-bucket.
+  ///
+  /// `fn` must be callable as
+  /// `std::optional<std::vector<std::byte>>(std::optional<std::span<const
+  /// std::byte>>)`.
+  template <typename Fn>
+  void Update(std::span<const std::byte> key, Fn&& fn) {
+    assert(!key.empty() && "update: zero-length key");
+
+    const auto index = LowerBound(key);
+    const bool exact = index < inodes_.size() &&
+                       CompareKeys(inodes_[index].Key(), key) == 0;
+
+    std::optional<std::span<const std::byte>> old;
+    if (exact) {
+      if (inodes_[index].flags != LeafFlag::kNone) {
+        ThrowError(Errc::kIncompatibleValue);
+      }
+      old = inodes_[index].Value();
+    }
+
+    std::optional<std::vector<std::byte>> value = fn(old);
+    const auto pos = inodes_.begin() + static_cast<std::ptrdiff_t>(index);
+
+    if (!value) {
+      if (exact) {
+        inodes_.erase(pos);
+        unbalanced_ = true;
+      }
+      return;
+    }
+
+    if (exact) {
+      inodes_[index].value = std::move(*value);
+      return;
+    }
+
+    if (tracker_ != nullptr) tracker_->Record(index, inodes_.size());
+    Inode inode;
+    inode.key.assign(key.begin(), key.end());
+    inode.value = std::move(*value);
+    inodes_.insert(pos, std::move(inode));
+  }
+
+  /// Update() for many keys in one pass. `keys` must be sorted and
+  /// distinct; `fn(i, old)` is called for keys[i] in order, with the same
+  /// contract as for Update(). Each search starts where the previous one
+  /// ended, and every result is collected before the node is touched, so
+  /// the node is rebuilt at most once and is left unchanged if `fn` or a
+  /// stored value throws partway through the batch.
+  template <typename Fn>
+  void UpdateSorted(std::span<const std::span<const std::byte>> keys, Fn&& fn) {
+    // The outcome for one key: at `index`, an existing inode replaced or
+    // erased, or a new one inserted from `added`.
+    struct Change {
+      std::size_t index;
+      bool exact;
+      std::optional<std::vector<std::byte>> value;
+    };
+
+    std::vector<Change> changes;
+    Inodes added;
+    bool erases = false;
+    auto from = inodes_.begin();
+
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      const auto key = keys[i];
+      assert(!key.empty() && "update: zero-length key");
+      assert((i == 0 || CompareKeys(keys[i - 1], key) < 0) &&
+             "update: keys not sorted");
+
+      const auto it =
+          std::partition_point(from, inodes_.end(), [&](const Inode& inode) {
+            return CompareKeys(inode.Key(), key) < 0;
+          });
+      const auto index = static_cast<std::size_t>(it - inodes_.begin());
+      const bool exact =
+          it != inodes_.end() && CompareKeys(it->Key(), key) == 0;
+      from = it;
+
+      std::optional<std::span<const std::byte>> old;
+      if (exact) {
+        if (it->flags != LeafFlag::kNone) ThrowError(Errc::kIncompatibleValue);
+        old = it->Value();
+      }
+
+      std::optional<std::vector<std::byte>> value = fn(i, old);
+      if (exact) {
+        erases = erases || !value;
+        changes.push_back(Change{index, true, std::move(value)});
+      } else if (value) {
+        auto& inode = added.emplace_back();
+        inode.key.assign(key.begin(), key.end());
+        inode.value = std::move(*value);
+        changes.push_back(Change{index, false, std::nullopt});
+      }
+    }
+
+    // Reserve the rebuilt vector while the node is still untouched; what
+    // follows only moves, so it cannot throw.
+    Inodes merged;
+    const bool rebuild = !added.empty() || erases;
+    if (rebuild) merged.reserve(inodes_.size() + added.size());
+
+    for (auto& change : changes) {
+      if (change.exact && change.value) {
+        inodes_[change.index].value = std::move(*change.value);
+      }
+    }
+    if (!rebuild) return;
+
+    // Merge the surviving inodes with the inserted ones. Inserts at an index
+    // sort before the inode already there.
+    auto ins = added.begin();
+    auto change = changes.begin();
+    for (std::size_t j = 0; j <= inodes_.size(); ++j) {
+      bool erased = false;
+      for (; change != changes.end() && change->index == j; ++change) {
+        if (change->exact) {
+          erased = !change->value;
+        } else {
+          if (tracker_ != nullptr) tracker_->Record(j, inodes_.size());
+          merged.push_back(std::move(*ins++));
+        }
+      }
+      if (j == inodes_.size()) break;
+      if (!erased) merged.push_back(std::move(inodes_[j]));
+    }
+
+    if (erases) unbalanced_ = true;
+    inodes_ = std::move(merged);
+  }
+
+  /// Removes a key from the node.
+  void Del(std::span<const std::byte> key) {
+    const auto index = LowerBound(key);
+
+    // Exit if the key isn't found.
+    if (index >= inodes_.size() ||
+        CompareKeys(inodes_[index].Key(), key) != 0) {
+      return;
+    }
+
+    inodes_.erase(inodes_.begin() + static_cast<std::ptrdiff_t>(index));
+
+    // Mark the node as needing rebalancing.
+    unbalanced_ = true;
+  }
+
+  /// Removes the keys in [begin, end) with a single erase and returns how
+  /// many there were.
+  std::size_t DelRange(std::span<const std::byte> begin,
+                       std::span<const std::byte> end) {
+    const auto first = LowerBound(begin);
+    const auto last = std::max(first, LowerBound(end));
+    if (first == last) return 0;
+
+    inodes_.erase(inodes_.begin() + static_cast<std::ptrdiff_t>(first),
+                  inodes_.begin() + static_cast<std::ptrdiff_t>(last));
+    unbalanced_ = true;
+
+    return last - first;
+  }
+
+  /// Moves the inodes matching `pred` into a new node of the same type,
+  /// preserving key order in both.
+  template <typename Pred>
+  [[nodiscard]] Node Extract(Pred pred) {
+    Node out(is_leaf_);
+    out.tracker_ = tracker_;
+
+    auto keep = std::stable_partition(
+        inodes_.begin(), inodes_.end(),
+        [&](const Inode& inode) { return !pred(inode); });
+    out.inodes_.assign(std::make_move_iterator(keep),
+                       std::make_move_iterator(inodes_.end()));
+    inodes_.erase(keep, inodes_.end());
+
+    return out;
+  }
+
+  /// Returns true if a key was deleted from this node since it was read.
+  [[nodiscard]] bool IsUnbalanced() const noexcept { return unbalanced_; }
+
+  /// Returns true if the node has fallen below the rebalance threshold
+  /// (a quarter of a page) or holds fewer than MinKeys() inodes.
+  [[nodiscard]] bool IsUnderfilled(std::size_t page_size) const noexcept {
+    return !(Size() > page_size / 4 && inodes_.size() > MinKeys());
+  }
+
+  /// Moves every inode of `right`, the next sibling, onto the end of this
+  /// node. `right` is left empty.
+  void MergeFrom(Node& right) {
+    assert(right.is_leaf_ == is_leaf_);
+    assert(inodes_.empty() || right.inodes_.empty() ||
+           CompareKeys(inodes_.back().Key(), right.inodes_.front().Key()) < 0);
+
+    inodes_.insert(inodes_.end(),
+                   std::make_move_iterator(right.inodes_.begin()),
+                   std::make_move_iterator(right.inodes_.end()));
+    right.inodes_.clear();
+    right.unbalanced_ = false;
+    unbalanced_ = false;
+  }
+
+  /// Initializes the node from a page. Throws kUnsupportedPage for a delta
+  /// leaf, which has no elements to read; see DeltaLeafView.
+  void Read(const Page& p) {
+    if (p.IsDeltaLeaf()) ThrowError(Errc::kUnsupportedPage);
+
+    pgid_ = p.id;
+    is_leaf_ = p.HasLeafElements();
+    unbalanced_ = false;
+    inodes_.clear();
+    inodes_.resize(p.count);
+
+    for (std::uint16_t i = 0; i < p.count; ++i) {
+      auto& inode = inodes_[i];
+
+      if (is_leaf_) {
+        const auto& elem = p.GetLeafElement(i);
+        const auto key = elem.Key();
+        const auto value = elem.Value();
+        inode.flags = elem.flags;
+        inode.key.assign(key.begin(), key.end());
+        inode.value.assign(value.begin(), value.end());
+      } else {
+        const auto& elem = p.GetBranchElement(i);
+        const auto key = elem.Key();
+        inode.pgid = elem.pgid;
+        inode.key.assign(key.begin(), key.end());
+      }
+
+      assert(!inode.key.empty() && "read: zero-length inode key");
+    }
+
+    // Save first key so we can find the node in the parent when we spill.
+    if (!inodes_.empty()) {
+      key_ = inodes_.front().key;
+    } else {
+      key_.clear();
+    }
+  }
+
+  /// Initializes the node from the page it was spilled to mid-transaction.
+  /// Unlike Read() this keeps the state of a dirty node: `key`, under which
+  /// the parent still refers to it, and whether it is unbalanced. The page
+  /// header holds the node's own page id, not the spill page's.
+  void ReadSpilled(const Page& p, std::span<const std::byte> key,
+                   bool unbalanced) {
+    Read(p);
+    key_.assign(key.begin(), key.end());
+    unbalanced_ = unbalanced;
+  }
+
+  /// Writes the items onto a page. The page must be at least Size() bytes
+  /// plus `reserved`, the number of bytes left free between the element
+  /// headers and the key data for an in-page search index.
+  void Write(Page& p, std::size_t reserved = 0) const {
+    // Initialize page.
+    p.flags = is_leaf_ ? PageFlag::kLeaf : PageFlag::kBranch;
+
+    assert(inodes_.size() < 0xFFFF && "inode overflow");
+    p.count = static_cast<std::uint16_t>(inodes_.size());
+
+    // Stop here if there are no items to write.
+    if (p.count == 0) return;
+
+    // Loop over each item and write it to the page.
+    std::byte* b =
+        p.DataPtr() + PageElementSize() * inodes_.size() + reserved;
+
+    for (std::uint16_t i = 0; i < p.count; ++i) {
+      const auto& item = inodes_[i];
+      assert(!item.key.empty() && "write: zero-length inode key");
+
+      // Write the page element.
+      if (is_leaf_) {
+        auto& elem = p.GetLeafElement(i);
+        elem.pos = static_cast<std::uint32_t>(
+            b - reinterpret_cast<const std::byte*>(&elem));
+        elem.flags = item.flags;
+        elem.ksize = static_cast<std::uint32_t>(item.key.size());
+        elem.vsize = static_cast<std::uint32_t>(item.value.size());
+      } else {
+        auto& elem = p.GetBranchElement(i);
+        elem.pos = static_cast<std::uint32_t>(
+            b - reinterpret_cast<const std::byte*>(&elem));
+        elem.ksize = static_cast<std::uint32_t>(item.key.size());
+        elem.pgid = item.pgid;
+        assert(elem.pgid != p.id && "write: circular dependency occurred");
+      }
+
+      // Write data for the element to the end of the page.
+      std::memcpy(b, item.key.data(), item.key.size());
+      b += item.key.size();
+      if (!item.value.empty()) {
+        std::memcpy(b, item.value.data(), item.value.size());
+        b += item.value.size();
+      }
+    }
+  }
+
+  /// Breaks up a node into multiple smaller nodes, if appropriate. This
+  /// node keeps the first piece and the remaining siblings are returned in
+  /// key order.
+  ///
+  /// Unlike the Go version, which always fills each page up to the
+  /// bucket's fill percent, the split point follows the insert pattern
+  /// recorded by the attached tracker:
+  ///   - ascending:  pack the left pages full, appends go to the last page.
+  ///   - descending: pack the right pages full, prepends go to the first page.
+  ///   - random:     split down the middle to leave room on both sides.
+  ///   - unknown:    fall back to `fill_percent`.
+  [[nodiscard]] std::vector<Node> Split(std::size_t page_size,
+                                        double fill_percent) {
+    std::vector<Node> siblings;
+
+    // Ignore the split if the page doesn't have at least enough nodes for
+    // two pages or if the nodes can fit in a single page.
+    if (inodes_.size() <= kMinKeysPerPage * 2 || SizeLessThan(page_size)) {
+      return siblings;
+    }
+
+    const auto pattern =
+        tracker_ != nullptr ? tracker_->Pattern() : InsertPattern::kUnknown;
+    const auto threshold =
+        static_cast<std::size_t>(static_cast<double>(page_size) *
+                                 SplitFillPercent(pattern, fill_percent));
+    const auto bounds = pattern == InsertPattern::kDescending
+                            ? SplitBoundsFromBack(page_size, threshold)
+                            : SplitBoundsFromFront(page_size, threshold);
+
+    siblings.reserve(bounds.size());
+    for (std::size_t i = 0; i < bounds.size(); ++i) {
+      const auto first =
+          inodes_.begin() + static_cast<std::ptrdiff_t>(bounds[i]);
+      const auto last =
+          i + 1 < bounds.size()
+              ? inodes_.begin() + static_cast<std::ptrdiff_t>(bounds[i + 1])
+              : inodes_.end();
+
+      Node& next = siblings.emplace_back(is_leaf_);
+      next.tracker_ = tracker_;
+      next.inodes_.assign(std::make_move_iterator(first),
+                          std::make_move_iterator(last));
+    }
+
+    if (!bounds.empty()) {
+      inodes_.erase(inodes_.begin() + static_cast<std::ptrdiff_t>(bounds[0]),
+                    inodes_.end());
+    }
+
+    return siblings;
+  }
+
+ private:
+  static constexpr std::size_t HeapBlockSize(std::size_t bytes) noexcept {
+    return bytes == 0 ? 0 : bytes + kHeapBlockOverhead;
+  }
+
+  /// Finds the inode stored under `old_key`, inserting an empty one if there
+  /// is none, and sets its key, page id and flags.
+  Inode& Upsert(std::span<const std::byte> old_key,
+                std::span<const std::byte> new_key, PageId pgid,
+                LeafFlag flags) {
+    assert(!old_key.empty() && "put: zero-length old key");
+    assert(!new_key.empty() && "put: zero-length new key");
+
+    // Find insertion index.
+    const auto index = LowerBound(old_key);
+
+    // Add capacity and shift nodes if we don't have an exact match and need
+    // to insert.
+    const bool exact = index < inodes_.size() &&
+                       CompareKeys(inodes_[index].Key(), old_key) == 0;
+    if (!exact) {
+      if (tracker_ != nullptr) tracker_->Record(index, inodes_.size());
+      inodes_.insert(inodes_.begin() + static_cast<std::ptrdiff_t>(index),
+                     Inode{});
+    }
+
+    auto& inode = inodes_[index];
+    inode.flags = flags;
+    inode.key.assign(new_key.begin(), new_key.end());
+    inode.pgid = pgid;
+    assert(!inode.key.empty() && "put: zero-length inode key");
+
+    return inode;
+  }
+
+  /// Fill percent used for a split under the given insert pattern, clamped
+  /// the same way as the bucket's fill percent.
+  static double SplitFillPercent(InsertPattern pattern, double fill_percent) {
+    switch (pattern) {
+      case InsertPattern::kAscending:
+      case InsertPattern::kDescending:
+        fill_percent = kMaxFillPercent;
+        break;
+      case InsertPattern::kRandom:
+        fill_percent = kDefaultFillPercent;
+        break;
+      case InsertPattern::kUnknown:
+        break;
+    }
+
+    return std::clamp(fill_percent, kMinFillPercent, kMaxFillPercent);
+  }
+
+  /// Size of the inode at `i` once written to a page.
+  [[nodiscard]] std::size_t ElementSize(std::size_t i) const noexcept {
+    return PageElementSize() + inodes_[i].key.size() + inodes_[i].value.size();
+  }
+
+  /// Start indexes of every piece after the first, filling pieces from the
+  /// front up to `threshold` bytes until the rest fits in `page_size`. Each
+  /// piece keeps at least kMinKeysPerPage inodes.
+  [[nodiscard]] std::vector<std::size_t> SplitBoundsFromFront(
+      std::size_t page_size, std::size_t threshold) const {
+    std::vector<std::size_t> bounds;
+    std::size_t start = 0;
+    std::size_t rest = Size();
+
+    // Stop once the remainder fits a page on its own, even if it is over
+    // the threshold, so no tiny trailing page is left behind.
+    while (inodes_.size() - start > kMinKeysPerPage * 2 && rest >= page_size) {
+      std::size_t sz = Page::kHeaderSize;
+      std::size_t index = start;
+      for (; index < inodes_.size() - kMinKeysPerPage; ++index) {
+        const auto elsize = ElementSize(index);
+        if (index - start >= kMinKeysPerPage && sz + elsize > threshold) break;
+        sz += elsize;
+      }
+
+      bounds.push_back(index);
+      rest -= sz - Page::kHeaderSize;
+      start = index;
+    }
+
+    return bounds;
+  }
+
+  /// Mirror of SplitBoundsFromFront() that fills pieces from the back, so
+  /// the first piece is the one left with spare room.
+  [[nodiscard]] std::vector<std::size_t> SplitBoundsFromBack(
+      std::size_t page_size, std::size_t threshold) const {
+    std::vector<std::size_t> bounds;
+    std::size_t end = inodes_.size();
+    std::size_t rest = Size();
+
+    while (end > kMinKeysPerPage * 2 && rest >= page_size) {
+      std::size_t sz = Page::kHeaderSize;
+      std::size_t index = end;
+      for (; index > kMinKeysPerPage; --index) {
+        const auto elsize = ElementSize(index - 1);
+        if (end - index >= kMinKeysPerPage && sz + elsize > threshold) break;
+        sz += elsize;
+      }
+
+      bounds.push_back(index);
+      rest -= sz - Page::kHeaderSize;
+      end = index;
+    }
+
+    std::reverse(bounds.begin(), bounds.end());
+
+    return bounds;
+  }
+
+  bool is_leaf_ = false;
+  bool unbalanced_ = false;
+  PageId pgid_{};
+  std::vector<std::byte> key_;
+  Inodes inodes_;
+  InsertPatternTracker* tracker_ = nullptr;
+};
+
+}  // namespace boltdb
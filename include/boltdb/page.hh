@@ -1,10 +1,19 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <compare>
+#include <cstddef>
 #include <cstdint>
+#include <format>
+#include <functional>
 #include <iostream>
+#include <iterator>
 #include <span>
+#include <string>
 #include <string_view>
+#include <type_traits>
+#include <vector>
 
 namespace boltdb {
 
@@ -23,17 +32,29 @@ enum class PageFlag : std::uint16_t {
   kLeaf = 0x02,
   kMeta = 0x04,
   kFreelist = 0x10,
+  kDeltaLeaf = 0x20,  ///< Leaf of u64 keys stored as delta-of-delta blocks.
+  kHashDirectory = 0x40,  ///< Directory of an extendible-hash bucket.
+  kHashBucket = 0x80,     ///< Leaf-layout page of an extendible-hash bucket.
+  kSearchIndex = 0x100,   ///< Branch page carrying an Eytzinger key index.
 };
 
 constexpr bool operator&(PageFlag a, PageFlag b) {
   return (static_cast<uint16_t>(a) & static_cast<uint16_t>(b)) != 0;
 }
 
+constexpr PageFlag operator|(PageFlag a, PageFlag b) {
+  return static_cast<PageFlag>(static_cast<uint16_t>(a) |
+                               static_cast<uint16_t>(b));
+}
+
 constexpr std::string_view PageFlagToString(PageFlag flags) {
   if (flags & PageFlag::kBranch) return "branch";
   if (flags & PageFlag::kLeaf) return "leaf";
   if (flags & PageFlag::kMeta) return "meta";
   if (flags & PageFlag::kFreelist) return "freelist";
+  if (flags & PageFlag::kDeltaLeaf) return "delta-leaf";
+  if (flags & PageFlag::kHashDirectory) return "hash-directory";
+  if (flags & PageFlag::kHashBucket) return "hash-bucket";
 
   return "unknown";
 }
@@ -41,6 +62,9 @@ constexpr std::string_view PageFlagToString(PageFlag flags) {
 enum class LeafFlag : std::uint32_t {
   kNone = 0x00,
   kBucket = 0x01,
+  kHashBucket = 0x02,  ///< Value is the header of an extendible-hash bucket.
+  kBlobRef = 0x04,     ///< Value is a BlobPointer into the blob log.
+  kContentRef = 0x08,  ///< Value is the hash of a deduplicated value.
 };
 
 /// A branch page element stores a key and a child page pointer.
@@ -80,6 +104,13 @@ struct LeafElement {
   std::uint32_t vsize;  ///< Value length in bytes.
 
   [[nodiscard]] bool IsBucket() const { return flags == LeafFlag::kBucket; }
+  [[nodiscard]] bool IsHashBucket() const {
+    return flags == LeafFlag::kHashBucket;
+  }
+  [[nodiscard]] bool IsBlobRef() const { return flags == LeafFlag::kBlobRef; }
+  [[nodiscard]] bool IsContentRef() const {
+    return flags == LeafFlag::kContentRef;
+  }
 
   [[nodiscard]] std::span<const std::byte> Key() const {
     const auto* base = reinterpret_cast<const std::byte*>(this);
@@ -106,6 +137,14 @@ struct LeafElement {
   }
 };
 
+/// Lexicographically compare two keys byte by byte, the same ordering as
+/// Go's `bytes.Compare`.
+constexpr std::strong_ordering CompareKeys(std::span<const std::byte> a,
+                                          std::span<const std::byte> b) {
+  return std::lexicographical_compare_three_way(a.begin(), a.end(), b.begin(),
+                                                b.end());
+}
+
 static_assert(std::is_trivially_copyable_v<BranchElement>);
 static_assert(std::is_trivially_copyable_v<LeafElement>);
 
@@ -136,6 +175,23 @@ struct Page {
   [[nodiscard]] bool IsFreelist() const noexcept {
     return flags & PageFlag::kFreelist;
   }
+  [[nodiscard]] bool IsDeltaLeaf() const noexcept {
+    return flags & PageFlag::kDeltaLeaf;
+  }
+  [[nodiscard]] bool HasSearchIndex() const noexcept {
+    return flags & PageFlag::kSearchIndex;
+  }
+  [[nodiscard]] bool IsHashDirectory() const noexcept {
+    return flags & PageFlag::kHashDirectory;
+  }
+  [[nodiscard]] bool IsHashBucket() const noexcept {
+    return flags & PageFlag::kHashBucket;
+  }
+
+  /// Leaf and hash bucket pages share the LeafElement layout.
+  [[nodiscard]] bool HasLeafElements() const noexcept {
+    return IsLeaf() || IsHashBucket();
+  }
 
   [[nodiscard]] std::string TypeName() const {
     auto sv = PageFlagToString(flags);
@@ -196,7 +252,7 @@ struct Page {
   }
 
   [[nodiscard]] LeafElement& GetLeafElement(std::uint16_t index) {
-    assert(IsLeaf() && index < count);
+    assert(HasLeafElements() && index < count);
 
     auto* elems = reinterpret_cast<LeafElement*>(DataPtr());
 
@@ -204,7 +260,7 @@ struct Page {
   }
 
   [[nodiscard]] const LeafElement& GetLeafElement(std::uint16_t index) const {
-    assert(IsLeaf() && index < count);
+    assert(HasLeafElements() && index < count);
 
     auto* elems = reinterpret_cast<const LeafElement*>(DataPtr());
 
@@ -214,7 +270,7 @@ struct Page {
   [[nodiscard]] std::span<LeafElement> LeafElements() {
     if (count == 0) return {};
 
-    assert(IsLeaf());
+    assert(HasLeafElements());
 
     return {reinterpret_cast<LeafElement*>(DataPtr()), count};
   }
@@ -222,7 +278,7 @@ struct Page {
   [[nodiscard]] std::span<const LeafElement> LeafElements() const {
     if (count == 0) return {};
 
-    assert(IsLeaf());
+    assert(HasLeafElements());
 
     return {reinterpret_cast<const LeafElement*>(DataPtr()), count};
   }
@@ -267,6 +323,15 @@ struct PageInfo {
 
 using PageIds = std::vector<PageId>;
 
+/// Maps a page id to the page in memory, e.g. a view into the mmap.
+using PageResolver = std::function<const Page*(PageId)>;
+
+/// A PageResolver that is also told the level of a cursor's path the page
+/// is for, the root being level zero. Once level n is resolved again the
+/// cursor no longer holds its old pages at n and below, so a resolver that
+/// pins pages may release them.
+using PathResolver = std::function<const Page*(PageId, std::size_t level)>;
+
 /// Merge two sorted PageId vectors into a sorted union.
 ///
 /// Unlike the Go version which uses sort.Search in a loop, we use
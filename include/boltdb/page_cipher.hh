@@ -0,0 +1,138 @@
+#pragma once
+
+#include <openssl/rand.h>
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+
+#include "boltdb/aes_gcm.hh"
+#include "boltdb/endian.hh"
+#include "boltdb/errors.hh"
+#include "boltdb/page.hh"
+#include "boltdb/type.hh"
+
+namespace boltdb {
+
+/// \brief PageCipher encrypts page runs at rest with AES-256-GCM under a
+///        per-DB key.
+///
+/// The header stays in the clear so the run length (`overflow`) can be read
+/// before decrypting. It is authenticated as associated data together with
+/// the writing txid, which the last kOverhead bytes of the run hold along
+/// with the IV and the tag:
+///
+/// ┌─────────────┬───────────────────────┬──────────┬────────┬─────────┐
+/// │ Page Header │ body (encrypted)    … │ u64 txid │ iv[12] │ tag[16] │
+/// └─────────────┴───────────────────────┴──────────┴────────┴─────────┘
+///
+/// Every Encrypt() draws a fresh random 96-bit IV from OpenSSL's CSPRNG.
+/// Nothing derived from the page id or txid would do: a freed page is
+/// reused under a new txid, and the txid of a rolled-back writer is handed
+/// to the next one, which then rewrites the same pages, spilled ones
+/// included, with different contents. With random IVs a repeat is only as
+/// likely as a birthday collision, which stays below 2^-32 for the first
+/// 2^32 writes under one key (NIST SP 800-38D, 8.3); a DB that writes more
+/// should be re-keyed. Nodes spilled to an encrypted DB are sized for
+/// `page_size - kOverhead`.
+///
+/// Pages are encrypted in the spill buffer just before they are written,
+/// and decrypted from the mmap into the buffer that holds decoded pages.
+class PageCipher {
+ public:
+  static constexpr std::size_t kIvSize = 12;
+
+  static constexpr std::size_t kOverhead =
+      sizeof(TransactionID) + kIvSize + AesGcm::kTagSize;
+
+  static constexpr std::size_t kKeySize = 32;
+
+  using Iv = std::array<std::byte, kIvSize>;
+
+  /// `key` must be kKeySize bytes; throws kInvalidKey otherwise.
+  explicit PageCipher(std::span<const std::byte> key) : gcm_(CheckKey(key)) {}
+
+  /// Encrypts the page run `run`, written by transaction `txid`, in place
+  /// under a fresh random IV. Throws kCipherFailed if none can be drawn.
+  void Encrypt(std::span<std::byte> run, TransactionID txid) const {
+    assert(run.size() >= Page::kHeaderSize + kOverhead);
+
+    const auto trailer = run.last(kOverhead);
+    StoreLittleEndian64(trailer.data(), txid);
+
+    auto* iv = trailer.data() + sizeof(TransactionID);
+    if (RAND_bytes(reinterpret_cast<unsigned char*>(iv), kIvSize) != 1) {
+      ThrowError(Errc::kCipherFailed);
+    }
+
+    const auto tag = gcm_.Seal({iv, kIvSize}, Aad(run), Body(run));
+    std::memcpy(iv + kIvSize, tag.data(), tag.size());
+  }
+
+  /// Decrypts the page run `src` into `dst`, which may be `src` itself.
+  /// Throws kDecryptionFailed if the run was modified or belongs to another
+  /// key; `dst` then holds the ciphertext.
+  void Decrypt(std::span<const std::byte> src,
+               std::span<std::byte> dst) const {
+    assert(src.size() == dst.size());
+    assert(src.size() >= Page::kHeaderSize + kOverhead);
+
+    if (dst.data() != src.data()) {
+      std::memcpy(dst.data(), src.data(), src.size());
+    }
+
+    const auto trailer = dst.last(kOverhead);
+    const auto* iv = trailer.data() + sizeof(TransactionID);
+    AesGcm::Tag tag;
+    std::memcpy(tag.data(), iv + kIvSize, tag.size());
+    if (!gcm_.Open({iv, kIvSize}, Aad(dst), Body(dst), tag)) {
+      ThrowError(Errc::kDecryptionFailed);
+    }
+  }
+
+  /// Transaction that wrote an encrypted run, from its trailer.
+  [[nodiscard]] static TransactionID WrittenBy(std::span<const std::byte> run) {
+    return LoadLittleEndian64(run.last(kOverhead).data());
+  }
+
+  /// IV an encrypted run was sealed under, from its trailer.
+  [[nodiscard]] static Iv IvOf(std::span<const std::byte> run) {
+    Iv iv;
+    std::memcpy(iv.data(), run.last(kOverhead).data() + sizeof(TransactionID),
+                kIvSize);
+
+    return iv;
+  }
+
+ private:
+  using AadBytes =
+      std::array<std::byte, Page::kHeaderSize + sizeof(TransactionID)>;
+
+  /// The page header followed by the txid in the trailer.
+  static AadBytes Aad(std::span<const std::byte> run) {
+    AadBytes aad;
+    std::memcpy(aad.data(), run.data(), Page::kHeaderSize);
+    std::memcpy(aad.data() + Page::kHeaderSize, run.last(kOverhead).data(),
+                sizeof(TransactionID));
+
+    return aad;
+  }
+
+  static std::span<std::byte> Body(std::span<std::byte> run) {
+    return run.subspan(Page::kHeaderSize,
+                       run.size() - Page::kHeaderSize - kOverhead);
+  }
+
+  static std::span<const std::byte> CheckKey(std::span<const std::byte> key) {
+    if (key.size() != kKeySize) ThrowError(Errc::kInvalidKey);
+
+    return key;
+  }
+
+  AesGcm gcm_;
+};
+
+}  // namespace boltdb
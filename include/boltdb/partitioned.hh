@@ -0,0 +1,203 @@
+#pragma once
+
+#include <cassert>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <format>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "boltdb/cursor.hh"
+#include "boltdb/endian.hh"
+#include "boltdb/errors.hh"
+#include "boltdb/merge_cursor.hh"
+
+namespace boltdb {
+
+/// Options for PartitionedDB.
+struct TimePartitionOptions {
+  /// Width of a partition in the units of the key's time component.
+  std::uint64_t period = 24 * 60 * 60;
+  /// Extracts the time component of a key. Defaults to its first 8 bytes
+  /// read big-endian, e.g. a seconds timestamp prefix, and throws
+  /// kKeyRequired for a key too short to hold one.
+  std::function<std::uint64_t(std::span<const std::byte>)> time_of =
+      [](std::span<const std::byte> key) {
+        if (key.size() < 8) ThrowError(Errc::kKeyRequired);
+        return LoadBigEndian64(key.data());
+      };
+};
+
+/// \brief PartitionCursor is a MergeCursor over several partitions that
+///        holds their handles.
+///
+/// Keys and values point into the partitions' pages, so each one stays
+/// open for as long as the cursor does, even if it is dropped meanwhile.
+template <typename DB>
+class PartitionCursor {
+ public:
+  PartitionCursor(std::vector<std::shared_ptr<DB>> dbs, MergeCursor cursor)
+      : dbs_(std::move(dbs)), cursor_(std::move(cursor)) {}
+
+  /// See MergeCursor::First().
+  std::optional<KeyValue> First() { return cursor_.First(); }
+
+  /// See MergeCursor::Seek().
+  std::optional<KeyValue> Seek(std::span<const std::byte> key) {
+    return cursor_.Seek(key);
+  }
+
+  /// See MergeCursor::Next().
+  std::optional<KeyValue> Next() { return cursor_.Next(); }
+
+  /// Index, among the partitions merged, of the item returned last.
+  [[nodiscard]] std::size_t Source() const noexcept {
+    return cursor_.Source();
+  }
+
+ private:
+  // Declared first so the handles outlive the cursor reading from them.
+  std::vector<std::shared_ptr<DB>> dbs_;
+  MergeCursor cursor_;
+};
+
+/// \brief PartitionedDB routes keys by their time component into one DB
+///        file per period.
+///
+/// Partitions live in a directory as `<period start>.db` and are opened on
+/// demand through the `open` callback. Retention is a file operation:
+/// DropBefore() closes and unlinks whole partitions, which takes the same
+/// time however much data they hold and leaves nothing to compact.
+///
+/// `DB` is the handle type the callback returns; handles given out, and
+/// cursors from NewCursor(), stay usable after their partition is dropped,
+/// until the last copy goes.
+template <typename DB>
+class PartitionedDB {
+ public:
+  using OpenFn = std::function<std::shared_ptr<DB>(
+      const std::filesystem::path& path, std::uint64_t start)>;
+
+  PartitionedDB(std::filesystem::path dir, OpenFn open,
+                TimePartitionOptions options = {})
+      : dir_(std::move(dir)), open_(std::move(open)),
+        options_(std::move(options)) {
+    assert(options_.period > 0);
+    std::filesystem::create_directories(dir_);
+
+    // Anything not named like a partition is left alone.
+    for (const auto& entry : std::filesystem::directory_iterator(dir_)) {
+      const auto& path = entry.path();
+      if (path.extension() != ".db") continue;
+
+      const auto stem = path.stem().string();
+      std::uint64_t start = 0;
+      const auto [end, ec] =
+          std::from_chars(stem.data(), stem.data() + stem.size(), start);
+      if (ec != std::errc{} || end != stem.data() + stem.size()) continue;
+      partitions_.emplace(start, nullptr);
+    }
+  }
+
+  PartitionedDB(const PartitionedDB&) = delete;
+  PartitionedDB& operator=(const PartitionedDB&) = delete;
+
+  /// Start of the partition holding time `t`.
+  [[nodiscard]] std::uint64_t PartitionOf(std::uint64_t t) const noexcept {
+    return t - t % options_.period;
+  }
+
+  /// The partition holding `key`, opened or created if needed.
+  std::shared_ptr<DB> For(std::span<const std::byte> key) {
+    return Open(PartitionOf(options_.time_of(key)));
+  }
+
+  /// The partition starting at `start`, opened or created if needed.
+  std::shared_ptr<DB> Open(std::uint64_t start) {
+    assert(start % options_.period == 0);
+
+    std::lock_guard lock(mu_);
+    auto& db = partitions_[start];
+    if (!db) db = open_(PathOf(start), start);
+
+    return db;
+  }
+
+  /// Starts of the existing partitions, oldest first.
+  [[nodiscard]] std::vector<std::uint64_t> Partitions() const {
+    std::lock_guard lock(mu_);
+    std::vector<std::uint64_t> starts;
+    for (const auto& [start, db] : partitions_) starts.push_back(start);
+
+    return starts;
+  }
+
+  /// Closes and deletes every partition that ends at or before `t`.
+  /// Returns the number dropped.
+  ///
+  /// Files are unlinked under the lock: otherwise an Open() of a dropped
+  /// period could create the file anew just before it is removed.
+  std::size_t DropBefore(std::uint64_t t) {
+    std::lock_guard lock(mu_);
+
+    std::size_t dropped = 0;
+    while (!partitions_.empty() &&
+           partitions_.begin()->first + options_.period <= t) {
+      std::filesystem::remove(PathOf(partitions_.begin()->first));
+      partitions_.erase(partitions_.begin());
+      ++dropped;
+    }
+
+    return dropped;
+  }
+
+  /// A cursor over every partition overlapping [from, to), in key order.
+  /// `cursor` positions a Cursor on one partition's bucket. Partitions are
+  /// combined with a MergeCursor, so the result is ordered even when the
+  /// time component is not a key prefix.
+  ///
+  /// The partitions are picked and opened in one step under the lock, so
+  /// one dropped concurrently is either merged, and kept open by the
+  /// cursor, or left out; it is never created again.
+  PartitionCursor<DB> NewCursor(std::uint64_t from, std::uint64_t to,
+                                const std::function<Cursor(DB&)>& cursor) {
+    std::vector<std::shared_ptr<DB>> dbs;
+    {
+      std::lock_guard lock(mu_);
+      for (auto& [start, db] : partitions_) {
+        if (start + options_.period <= from || start >= to) continue;
+        if (!db) db = open_(PathOf(start), start);
+        dbs.push_back(db);
+      }
+    }
+
+    std::vector<Cursor> cursors;
+    cursors.reserve(dbs.size());
+    for (const auto& db : dbs) cursors.push_back(cursor(*db));
+
+    return PartitionCursor<DB>(std::move(dbs), MergeCursor(std::move(cursors)));
+  }
+
+ private:
+  [[nodiscard]] std::filesystem::path PathOf(std::uint64_t start) const {
+    return dir_ / std::format("{:020}.db", start);
+  }
+
+  std::filesystem::path dir_;
+  OpenFn open_;
+  TimePartitionOptions options_;
+  mutable std::mutex mu_;
+  std::map<std::uint64_t, std::shared_ptr<DB>> partitions_;
+};
+
+}  // namespace boltdb
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <span>
+#include <utility>
+
+#include "boltdb/background.hh"
+#include "boltdb/page.hh"
+
+namespace boltdb {
+
+/// \brief RebalanceQueue collects underfilled leaf pages whose merge was
+///        deferred at commit time.
+///
+/// Commits that skip rebalancing record the ids of the leaves they left
+/// below the threshold. Ids are kept sorted and de-duplicated so a batch
+/// touches neighbouring leaves together. Taken ids stay in flight until
+/// they are requeued or done, so one forgotten meanwhile is not put back.
+/// All methods are thread-safe.
+class RebalanceQueue {
+ public:
+  /// Record pages left underfilled by a commit.
+  void Record(std::span<const PageId> ids) {
+    std::lock_guard lock(mu_);
+    pending_.insert(ids.begin(), ids.end());
+  }
+
+  /// Drop pages that were freed or rewritten since they were recorded; a
+  /// page id is only meaningful until the page is released to the freelist.
+  void Forget(std::span<const PageId> ids) {
+    std::lock_guard lock(mu_);
+    for (auto id : ids) {
+      pending_.erase(id);
+      taken_.erase(id);
+    }
+  }
+
+  /// Remove and return up to `max` pending pages in ascending order. They
+  /// are in flight until passed to Requeue() or Done().
+  [[nodiscard]] PageIds Take(std::size_t max) {
+    std::lock_guard lock(mu_);
+
+    PageIds batch;
+    batch.reserve(std::min(max, pending_.size()));
+    while (!pending_.empty() && batch.size() < max) {
+      batch.push_back(pending_.extract(pending_.begin()).value());
+    }
+    taken_.insert(batch.begin(), batch.end());
+
+    return batch;
+  }
+
+  /// Put back a batch that could not be merged, less any page forgotten
+  /// since it was taken.
+  void Requeue(std::span<const PageId> ids) {
+    std::lock_guard lock(mu_);
+    for (auto id : ids) {
+      if (taken_.erase(id) > 0) pending_.insert(id);
+    }
+  }
+
+  /// Mark a batch as merged.
+  void Done(std::span<const PageId> ids) {
+    std::lock_guard lock(mu_);
+    for (auto id : ids) taken_.erase(id);
+  }
+
+  [[nodiscard]] std::size_t Size() const {
+    std::lock_guard lock(mu_);
+    return pending_.size();
+  }
+
+  [[nodiscard]] bool Empty() const { return Size() == 0; }
+
+ private:
+  mutable std::mutex mu_;
+  std::set<PageId> pending_;
+  std::set<PageId> taken_;  // In flight between Take() and Requeue()/Done().
+};
+
+/// Options for DeferredRebalancer.
+struct RebalanceOptions {
+  /// Maximum number of leaves merged by one background write transaction.
+  std::size_t batch_size = 64;
+  /// How often the queue is checked when nobody calls Wake().
+  std::chrono::milliseconds interval{100};
+};
+
+/// \brief DeferredRebalancer merges underfilled leaves off the commit path.
+///
+/// The merge function runs a small write transaction over a batch of
+/// recorded leaves. It must not wait for the writer lock: if a writer is
+/// active it returns false, the batch is put back, and the worker sleeps
+/// until the next interval, so background merges only ever use an idle
+/// writer.
+class DeferredRebalancer {
+ public:
+  /// Merges the leaves in the batch. Returns false if the writer was busy.
+  using MergeFn = std::function<bool(std::span<const PageId>)>;
+
+  DeferredRebalancer(MergeFn merge, RebalanceOptions options = {})
+      : merge_(std::move(merge)),
+        options_(options),
+        worker_(std::make_unique<BackgroundWorker>([this] { return Step(); },
+                                                   options_.interval)) {}
+
+  DeferredRebalancer(const DeferredRebalancer&) = delete;
+  DeferredRebalancer& operator=(const DeferredRebalancer&) = delete;
+
+  ~DeferredRebalancer() { worker_->Stop(); }
+
+  /// Called by a commit that skipped rebalancing.
+  void Record(std::span<const PageId> ids) {
+    if (ids.empty()) return;
+
+    queue_.Record(ids);
+    worker_->Wake();
+  }
+
+  /// Called when pages are freed so stale ids are never merged.
+  void Forget(std::span<const PageId> ids) { queue_.Forget(ids); }
+
+  /// Called when the writer is released, a good moment to run a batch.
+  void NotifyWriterIdle() {
+    if (!queue_.Empty()) worker_->Wake();
+  }
+
+  [[nodiscard]] std::size_t Pending() const { return queue_.Size(); }
+
+ private:
+  /// Runs one batch. Returns true if there may be more work right away.
+  bool Step() {
+    auto batch = queue_.Take(options_.batch_size);
+    if (batch.empty()) return false;
+
+    if (!merge_(batch)) {
+      queue_.Requeue(batch);
+      return false;
+    }
+    queue_.Done(batch);
+
+    return !queue_.Empty();
+  }
+
+  MergeFn merge_;
+  RebalanceOptions options_;
+  RebalanceQueue queue_;
+  std::unique_ptr<BackgroundWorker> worker_;
+};
+
+}  // namespace boltdb
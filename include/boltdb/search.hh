@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+#include "boltdb/page.hh"
+
+namespace boltdb {
+
+/// \brief KeySearch selects how a bucket's pages are searched.
+enum class KeySearch : std::uint8_t {
+  kBinary,         ///< Plain binary search; right for any key distribution.
+  kInterpolation,  ///< For uniformly distributed keys, e.g. hashes.
+};
+
+/// Interpolation probes before falling back to binary search.
+inline constexpr int kMaxInterpolationProbes = 3;
+
+namespace detail {
+
+/// Length of the common prefix of two keys.
+inline std::size_t CommonPrefix(std::span<const std::byte> a,
+                                std::span<const std::byte> b) noexcept {
+  const auto n = std::min(a.size(), b.size());
+  std::size_t i = 0;
+  while (i < n && a[i] == b[i]) ++i;
+
+  return i;
+}
+
+/// The 8 bytes of `key` following `skip`, big-endian, zero padded. Keys
+/// ordered lexicographically map to non-decreasing heads.
+inline std::uint64_t KeyHead(std::span<const std::byte> key,
+                             std::size_t skip) noexcept {
+  std::uint64_t v = 0;
+  for (std::size_t i = 0; i < 8; ++i) {
+    const auto j = skip + i;
+    v = (v << 8) |
+        (j < key.size() ? std::to_integer<std::uint64_t>(key[j]) : 0);
+  }
+
+  return v;
+}
+
+}  // namespace detail
+
+/// Returns the first index in `elems` for which `pred` is false, where
+/// `pred` is true for a prefix of the elements (like std::partition_point).
+///
+/// The key range of the remaining window is treated as numeric, taking the
+/// 8 bytes after the window's common prefix, and the next probe is placed
+/// where `key` would sit if keys were uniformly spread. After
+/// kMaxInterpolationProbes the window is finished with binary search, so
+/// skewed pages cost at most a few extra comparisons.
+template <typename Elem, typename Pred>
+std::size_t InterpolationPartitionPoint(std::span<const Elem> elems,
+                                        std::span<const std::byte> key,
+                                        Pred pred) {
+  const auto n = elems.size();
+  if (n == 0 || !pred(elems[0])) return 0;
+  if (pred(elems[n - 1])) return n;
+
+  // Invariant: pred(elems[lo]) is true and pred(elems[hi - 1]) is false.
+  std::size_t lo = 0;
+  std::size_t hi = n;
+
+  for (int probe = 0; probe < kMaxInterpolationProbes && hi - lo > 2;
+       ++probe) {
+    const auto first = elems[lo].Key();
+    const auto last = elems[hi - 1].Key();
+    const auto skip = detail::CommonPrefix(first, last);
+    const auto a = detail::KeyHead(first, skip);
+    const auto b = detail::KeyHead(last, skip);
+    if (b <= a) break;
+    const auto t = std::clamp(detail::KeyHead(key, skip), a, b);
+
+    const auto frac = static_cast<double>(t - a) / static_cast<double>(b - a);
+    auto pos = lo + static_cast<std::size_t>(
+                        frac * static_cast<double>(hi - 1 - lo));
+    pos = std::clamp(pos, lo + 1, hi - 2);
+
+    if (pred(elems[pos])) {
+      lo = pos;
+    } else {
+      hi = pos + 1;
+    }
+  }
+
+  const auto it = std::partition_point(elems.begin() + lo + 1,
+                                       elems.begin() + hi - 1, pred);
+
+  return static_cast<std::size_t>(it - elems.begin());
+}
+
+/// Index of the first leaf element whose key is not less than `key`.
+inline std::size_t SearchLeaf(std::span<const LeafElement> elems,
+                              std::span<const std::byte> key,
+                              KeySearch mode) {
+  const auto pred = [&](const LeafElement& e) {
+    return CompareKeys(e.Key(), key) < 0;
+  };
+  if (mode == KeySearch::kInterpolation) {
+    return InterpolationPartitionPoint(elems, key, pred);
+  }
+
+  return static_cast<std::size_t>(
+      std::partition_point(elems.begin(), elems.end(), pred) - elems.begin());
+}
+
+/// Index of the branch element whose child covers `key`: the last element
+/// not greater than `key`, or the first one.
+inline std::size_t SearchBranch(std::span<const BranchElement> elems,
+                                std::span<const std::byte> key,
+                                KeySearch mode) {
+  const auto pred = [&](const BranchElement& e) {
+    return CompareKeys(e.Key(), key) <= 0;
+  };
+  std::size_t index;
+  if (mode == KeySearch::kInterpolation) {
+    index = InterpolationPartitionPoint(elems, key, pred);
+  } else {
+    index = static_cast<std::size_t>(
+        std::partition_point(elems.begin(), elems.end(), pred) -
+        elems.begin());
+  }
+
+  return index > 0 ? index - 1 : 0;
+}
+
+}  // namespace boltdb
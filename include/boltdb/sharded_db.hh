@@ -0,0 +1,361 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "boltdb/endian.hh"
+#include "boltdb/file.hh"
+#include "boltdb/hash.hh"
+#include "boltdb/page.hh"
+
+namespace boltdb {
+
+/// Id of a transaction spanning several shards.
+using GlobalTxId = std::uint64_t;
+
+// ====================================================================
+// Routing
+// ====================================================================
+
+/// \brief ShardRouter maps keys to shards, by hash or by key range.
+class ShardRouter {
+ public:
+  /// Spreads keys evenly over `shards` by hash; range scans touch all of
+  /// them.
+  static ShardRouter ByHash(std::size_t shards) {
+    assert(shards > 0);
+    ShardRouter r;
+    r.shards_ = shards;
+
+    return r;
+  }
+
+  /// Shard i holds the keys in [splits[i - 1], splits[i]), so there is one
+  /// shard more than there are split keys. `splits` must be sorted.
+  static ShardRouter ByRange(std::vector<std::vector<std::byte>> splits) {
+    assert(std::is_sorted(splits.begin(), splits.end(),
+                          [](const auto& a, const auto& b) {
+                            return CompareKeys(a, b) < 0;
+                          }));
+    ShardRouter r;
+    r.shards_ = splits.size() + 1;
+    r.splits_ = std::move(splits);
+
+    return r;
+  }
+
+  [[nodiscard]] std::size_t Shards() const noexcept { return shards_; }
+
+  /// The shard holding `key`.
+  [[nodiscard]] std::size_t ShardOf(std::span<const std::byte> key) const {
+    if (splits_.empty()) return HashBytes(key) % shards_;
+
+    const auto it = std::upper_bound(
+        splits_.begin(), splits_.end(), key,
+        [](std::span<const std::byte> k, const std::vector<std::byte>& split) {
+          return CompareKeys(k, split) < 0;
+        });
+
+    return static_cast<std::size_t>(it - splits_.begin());
+  }
+
+ private:
+  ShardRouter() = default;
+
+  std::size_t shards_ = 1;
+  std::vector<std::vector<std::byte>> splits_;
+};
+
+// ====================================================================
+// Two-phase commit
+// ====================================================================
+
+/// \brief ShardParticipant is one shard's side of a cross-shard commit,
+///        implemented over that shard's DB file and writer.
+class ShardParticipant {
+ public:
+  virtual ~ShardParticipant() = default;
+
+  /// Makes the shard's part of `gtid` durable without making it visible,
+  /// e.g. by writing its pages and a prepare record but not the meta page.
+  /// Returns false to vote for abort.
+  virtual bool Prepare(GlobalTxId gtid) = 0;
+
+  /// Makes a prepared `gtid` visible.
+  virtual void Commit(GlobalTxId gtid) = 0;
+
+  /// Discards `gtid`, prepared or not.
+  virtual void Abort(GlobalTxId gtid) = 0;
+
+  /// Transactions prepared but neither committed nor aborted, e.g. after a
+  /// crash between the two phases.
+  [[nodiscard]] virtual std::vector<GlobalTxId> InDoubt() = 0;
+};
+
+/// \brief CoordinatorLog durably records cross-shard commit decisions.
+///
+/// Only commits are logged: a prepared transaction without a commit record
+/// is aborted on recovery (presumed abort), so aborts cost no write. Each
+/// record is
+///
+/// ┌──────────┬──────────┬──────────────┐
+/// │ u64 kind │ u64 gtid │ u64 checksum │
+/// └──────────┴──────────┴──────────────┘
+///
+/// and a torn record at the end is ignored. Once every shard has applied a
+/// decision it is marked Applied(), and every `checkpoint_every` records
+/// the log is rewritten to a watermark record, which keeps ids increasing
+/// across restarts, plus the decisions not yet applied. The rewrite goes
+/// to a temporary file that is synced and renamed over the log, so a crash
+/// leaves either the old log or the new one.
+class CoordinatorLog {
+ public:
+  explicit CoordinatorLog(std::filesystem::path path,
+                          std::size_t checkpoint_every = 1024)
+      : path_(std::move(path)),
+        file_(path_, O_RDWR | O_CREAT),
+        checkpoint_every_(checkpoint_every) {
+    const auto end = file_.Size();
+    for (std::uint64_t off = 0; off + kRecordSize <= end; off += kRecordSize) {
+      std::array<std::byte, kRecordSize> rec{};
+      if (!file_.ReadAt(rec, off) ||
+          HashBytes(std::span(rec).first(16)) !=
+              LoadLittleEndian64(rec.data() + 16)) {
+        break;
+      }
+
+      const auto kind = LoadLittleEndian64(rec.data());
+      const auto gtid = LoadLittleEndian64(rec.data() + 8);
+      if (kind == kCommit) committed_.insert(gtid);
+      last_ = std::max(last_, gtid);
+      tail_ = off + kRecordSize;
+    }
+  }
+
+  /// Durably records that `gtid` commits.
+  void LogCommit(GlobalTxId gtid) {
+    Append(file_, tail_, kCommit, gtid);
+    file_.Sync();
+    committed_.insert(gtid);
+  }
+
+  [[nodiscard]] bool Committed(GlobalTxId gtid) const {
+    return committed_.contains(gtid);
+  }
+
+  /// Marks the decision for `gtid` as applied on every shard, so it need
+  /// not survive the next checkpoint, and checkpoints when due.
+  void Applied(GlobalTxId gtid) {
+    committed_.erase(gtid);
+    if (Records() >= committed_.size() + checkpoint_every_) Checkpoint();
+  }
+
+  /// The largest id in the log.
+  [[nodiscard]] GlobalTxId Last() const noexcept { return last_; }
+
+  /// Records in the log file.
+  [[nodiscard]] std::size_t Records() const noexcept {
+    return static_cast<std::size_t>(tail_ / kRecordSize);
+  }
+
+  /// Drops all decisions, keeping only the largest id seen here or in
+  /// `watermark`.
+  void Reset(GlobalTxId watermark = 0) {
+    committed_.clear();
+    last_ = std::max(last_, watermark);
+    Checkpoint();
+  }
+
+ private:
+  static constexpr std::size_t kRecordSize = 24;
+  static constexpr std::uint64_t kCommit = 1;
+  static constexpr std::uint64_t kWatermark = 2;
+
+  void Append(File& file, std::uint64_t& tail, std::uint64_t kind,
+              GlobalTxId gtid) {
+    std::array<std::byte, kRecordSize> rec{};
+    StoreLittleEndian64(rec.data(), kind);
+    StoreLittleEndian64(rec.data() + 8, gtid);
+    StoreLittleEndian64(rec.data() + 16, HashBytes(std::span(rec).first(16)));
+    file.WriteAt(rec, tail);
+    tail += kRecordSize;
+    last_ = std::max(last_, gtid);
+  }
+
+  /// Replaces the log with a watermark and the decisions not yet applied.
+  void Checkpoint() {
+    auto tmp_path = path_;
+    tmp_path += ".tmp";
+    File tmp(tmp_path, O_RDWR | O_CREAT | O_TRUNC);
+    std::uint64_t tail = 0;
+    Append(tmp, tail, kWatermark, last_);
+    for (const auto gtid : committed_) Append(tmp, tail, kCommit, gtid);
+    tmp.Sync();
+
+    std::filesystem::rename(tmp_path, path_);
+    const auto dir = path_.parent_path();
+    File::SyncDirectory(dir.empty() ? "." : dir);
+    file_ = std::move(tmp);
+    tail_ = tail;
+  }
+
+  std::filesystem::path path_;
+  File file_;
+  std::size_t checkpoint_every_;
+  std::uint64_t tail_ = 0;
+  GlobalTxId last_ = 0;
+  std::set<GlobalTxId> committed_;
+};
+
+/// \brief ShardedDB spreads keys over N DB files, each with its own writer,
+///        so writes to different shards commit in parallel.
+///
+/// A transaction touching one shard commits on that shard alone. One that
+/// touches several uses two-phase commit: every shard prepares in
+/// parallel, the decision is written to the coordinator log, then every
+/// shard commits in parallel. The log write is the commit point; a crash
+/// before it aborts the transaction everywhere, one after it commits it
+/// everywhere once Recover() has run. The coordinator log is checkpointed
+/// every `checkpoint_every` decisions.
+class ShardedDB {
+ public:
+  ShardedDB(ShardRouter router,
+            std::vector<std::unique_ptr<ShardParticipant>> shards,
+            const std::filesystem::path& coordinator_log,
+            std::size_t checkpoint_every = 1024)
+      : router_(std::move(router)),
+        shards_(std::move(shards)),
+        log_(coordinator_log, checkpoint_every) {
+    assert(router_.Shards() == shards_.size());
+    next_ = log_.Last() + 1;
+  }
+
+  ShardedDB(const ShardedDB&) = delete;
+  ShardedDB& operator=(const ShardedDB&) = delete;
+
+  [[nodiscard]] const ShardRouter& Router() const noexcept { return router_; }
+
+  [[nodiscard]] ShardParticipant& Shard(std::size_t i) { return *shards_[i]; }
+
+  /// Starts a transaction and returns its id, under which each touched
+  /// shard collects its writes.
+  GlobalTxId Begin() {
+    std::lock_guard lock(mu_);
+    return next_++;
+  }
+
+  /// Commits `gtid` on the shards it wrote to. Returns false, with the
+  /// transaction aborted everywhere, if a shard voted no. If a shard throws
+  /// while preparing, every shard is aborted and the exception propagates;
+  /// if one throws while committing, Recover() settles it.
+  bool Commit(GlobalTxId gtid, std::span<const std::size_t> touched) {
+    std::vector<std::size_t> shards(touched.begin(), touched.end());
+    std::sort(shards.begin(), shards.end());
+    shards.erase(std::unique(shards.begin(), shards.end()), shards.end());
+    if (shards.empty()) return true;
+
+    // Prepare on every shard, keeping the first failure so that the shards
+    // already prepared are released rather than left until a restart.
+    std::mutex error_mu;
+    std::exception_ptr error;
+    const auto votes = ForEach(shards, [&](ShardParticipant& s) {
+      try {
+        return s.Prepare(gtid);
+      } catch (...) {
+        std::lock_guard lock(error_mu);
+        if (!error) error = std::current_exception();
+        return false;
+      }
+    });
+    const bool commit =
+        !error && std::ranges::all_of(votes, [](bool v) { return v; });
+
+    // One shard: its own commit is atomic.
+    if (commit && shards.size() > 1) {
+      std::lock_guard lock(mu_);
+      log_.LogCommit(gtid);
+    }
+    ForEach(shards, [&](ShardParticipant& s) {
+      if (commit) {
+        s.Commit(gtid);
+      } else if (error) {
+        // Presumed abort: Recover() aborts whatever this leaves prepared,
+        // and the prepare failure is the error to report.
+        try {
+          s.Abort(gtid);
+        } catch (...) {
+        }
+      } else {
+        s.Abort(gtid);
+      }
+      return true;
+    });
+    if (error) std::rethrow_exception(error);
+
+    if (commit && shards.size() > 1) {
+      std::lock_guard lock(mu_);
+      log_.Applied(gtid);
+    }
+
+    return commit;
+  }
+
+  /// Resolves transactions left in doubt by a crash: those logged as
+  /// committed are committed, the rest aborted. Call before Begin().
+  void Recover() {
+    std::lock_guard lock(mu_);
+    GlobalTxId last = 0;
+    for (auto& shard : shards_) {
+      for (const auto gtid : shard->InDoubt()) {
+        if (log_.Committed(gtid)) {
+          shard->Commit(gtid);
+        } else {
+          shard->Abort(gtid);
+        }
+        last = std::max(last, gtid);
+      }
+    }
+
+    // Prepared ids never reached the log; keep them from being reused.
+    log_.Reset(last);
+    next_ = std::max(next_, log_.Last() + 1);
+  }
+
+ private:
+  /// Runs `fn` on the given shards in parallel and returns the results.
+  template <typename Fn>
+  std::vector<bool> ForEach(std::span<const std::size_t> shards, Fn fn) {
+    std::vector<std::future<bool>> futures;
+    futures.reserve(shards.size());
+    for (std::size_t i = 1; i < shards.size(); ++i) {
+      futures.push_back(std::async(std::launch::async, fn,
+                                   std::ref(*shards_[shards[i]])));
+    }
+
+    std::vector<bool> results;
+    results.push_back(fn(*shards_[shards[0]]));
+    for (auto& f : futures) results.push_back(f.get());
+
+    return results;
+  }
+
+  ShardRouter router_;
+  std::vector<std::unique_ptr<ShardParticipant>> shards_;
+  std::mutex mu_;
+  CoordinatorLog log_;
+  GlobalTxId next_ = 1;
+};
+
+}  // namespace boltdb
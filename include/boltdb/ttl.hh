@@ -0,0 +1,220 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "boltdb/background.hh"
+#include "boltdb/endian.hh"
+#include "boltdb/node.hh"
+#include "boltdb/page.hh"
+
+namespace boltdb {
+
+// ====================================================================
+// Expiry index
+// ====================================================================
+
+/// Clock of key expiry times, stored as milliseconds since the epoch.
+using TtlClock = std::chrono::system_clock;
+
+/// Name of the hidden sub-bucket holding a bucket's expiry index.
+inline constexpr std::string_view kTtlBucketName{"\0ttl", 4};
+
+/// The hidden sub-bucket keeps two key spaces:
+///
+///   kExpiryPrefix | u64 expiry (big-endian) | key  ->  (empty)
+///   kKeyPrefix    | key                           ->  u64 expiry
+///
+/// The first orders keys by expiry, so everything due is a prefix of it and
+/// is found without scanning the data; the second finds the entry to drop
+/// when a key's expiry changes.
+inline constexpr std::byte kExpiryPrefix{0x01};
+inline constexpr std::byte kKeyPrefix{0x02};
+
+namespace detail {
+
+inline std::uint64_t ToExpiryMillis(TtlClock::time_point t) {
+  using std::chrono::milliseconds;
+  const auto ms =
+      std::chrono::duration_cast<milliseconds>(t.time_since_epoch()).count();
+
+  return ms < 0 ? 0 : static_cast<std::uint64_t>(ms);
+}
+
+inline std::vector<std::byte> ExpiryIndexKey(std::uint64_t expiry,
+                                             std::span<const std::byte> key) {
+  std::vector<std::byte> out(1 + 8 + key.size());
+  out[0] = kExpiryPrefix;
+  StoreBigEndian64(out.data() + 1, expiry);
+  std::copy(key.begin(), key.end(), out.begin() + 9);
+
+  return out;
+}
+
+inline std::vector<std::byte> KeyIndexKey(std::span<const std::byte> key) {
+  std::vector<std::byte> out(1 + key.size());
+  out[0] = kKeyPrefix;
+  std::copy(key.begin(), key.end(), out.begin() + 1);
+
+  return out;
+}
+
+}  // namespace detail
+
+/// Returns the expiry of `key` recorded in the expiry index `ttl`.
+inline std::optional<TtlClock::time_point> ExpiryOf(
+    const Node& ttl, std::span<const std::byte> key) {
+  const auto* stored = ttl.Find(detail::KeyIndexKey(key));
+  if (stored == nullptr) return std::nullopt;
+
+  return TtlClock::time_point(std::chrono::duration_cast<TtlClock::duration>(
+      std::chrono::milliseconds(LoadBigEndian64(stored->Value().data()))));
+}
+
+/// Sets or, with nothing, clears the expiry of `key` in the expiry index.
+inline void SetExpiry(Node& ttl, std::span<const std::byte> key,
+                      std::optional<TtlClock::time_point> expires_at) {
+  const auto by_key = detail::KeyIndexKey(key);
+  if (const auto* old = ttl.Find(by_key)) {
+    ttl.Del(detail::ExpiryIndexKey(LoadBigEndian64(old->Value().data()), key));
+  }
+
+  if (!expires_at) {
+    ttl.Del(by_key);
+    return;
+  }
+
+  const auto expiry = detail::ToExpiryMillis(*expires_at);
+  std::array<std::byte, 8> stored{};
+  StoreBigEndian64(stored.data(), expiry);
+  ttl.Put(by_key, by_key, stored, PageId{0}, LeafFlag::kNone);
+
+  const auto by_expiry = detail::ExpiryIndexKey(expiry, key);
+  ttl.Put(by_expiry, by_expiry, {}, PageId{0}, LeafFlag::kNone);
+}
+
+/// Puts `key` into `data` and records that it expires at `expires_at`.
+inline void PutWithTtl(Node& data, Node& ttl, std::span<const std::byte> key,
+                       std::span<const std::byte> value,
+                       TtlClock::time_point expires_at) {
+  data.Put(key, key, value, PageId{0}, LeafFlag::kNone);
+  SetExpiry(ttl, key, expires_at);
+}
+
+/// Returns whether `key` has expired by `now`. Readers use this to hide
+/// keys that are due but not reaped yet.
+inline bool IsExpired(const Node& ttl, std::span<const std::byte> key,
+                      TtlClock::time_point now) {
+  const auto expiry = ExpiryOf(ttl, key);
+
+  return expiry && *expiry <= now;
+}
+
+/// Deletes up to `limit` keys of `data` that expired by `now`, oldest
+/// expiry first, and returns how many were deleted.
+///
+/// The due entries are a contiguous run at the front of the expiry index
+/// and are removed with one range delete; the data keys and their
+/// key-to-expiry entries are removed in single sorted passes.
+inline std::size_t ReapExpired(Node& data, Node& ttl, TtlClock::time_point now,
+                               std::size_t limit) {
+  const std::array<std::byte, 1> first{kExpiryPrefix};
+  const auto begin = ttl.LowerBound(first);
+  const auto& inodes = ttl.GetInodes();
+  const auto due = detail::ToExpiryMillis(now);
+
+  std::vector<std::vector<std::byte>> keys;
+  std::size_t end = begin;
+  for (; end < inodes.size() && keys.size() < limit; ++end) {
+    const auto k = inodes[end].Key();
+    if (k[0] != kExpiryPrefix || LoadBigEndian64(k.data() + 1) > due) break;
+    keys.emplace_back(k.begin() + 9, k.end());
+  }
+  if (keys.empty()) return 0;
+
+  // The index entries [begin, end) are due. With nothing after them the
+  // key-to-expiry entries, if any, bound the range.
+  const auto bound = end < inodes.size() ? inodes[end].Key()
+                                         : std::span(&kKeyPrefix, 1);
+  ttl.DelRange(first, std::vector<std::byte>(bound.begin(), bound.end()));
+
+  std::sort(keys.begin(), keys.end(), [](const auto& a, const auto& b) {
+    return CompareKeys(a, b) < 0;
+  });
+  const auto none = [](std::size_t, auto) {
+    return std::optional<std::vector<std::byte>>();
+  };
+
+  std::vector<std::span<const std::byte>> spans(keys.begin(), keys.end());
+  data.UpdateSorted(spans, none);
+
+  std::vector<std::vector<std::byte>> by_key;
+  for (const auto& key : keys) by_key.push_back(detail::KeyIndexKey(key));
+  spans.assign(by_key.begin(), by_key.end());
+  ttl.UpdateSorted(spans, none);
+
+  return keys.size();
+}
+
+// ====================================================================
+// Reaper
+// ====================================================================
+
+/// Options for TtlReaper.
+struct TtlReaperOptions {
+  /// Maximum number of keys deleted by one write transaction.
+  std::size_t batch_size = 1024;
+  /// How often expired keys are looked for.
+  std::chrono::milliseconds interval{1000};
+};
+
+/// \brief TtlReaper deletes expired keys in the background.
+///
+/// The reap function runs one bounded write transaction that calls
+/// ReapExpired() with the given limit and returns the number of keys it
+/// deleted. A full batch means more keys are due and the next transaction
+/// starts right away; otherwise the reaper sleeps until the next interval,
+/// so a backlog is worked off in short transactions that never hold the
+/// writer for long.
+class TtlReaper {
+ public:
+  using ReapFn = std::function<std::size_t(std::size_t limit)>;
+
+  explicit TtlReaper(ReapFn reap, TtlReaperOptions options = {})
+      : reap_(std::move(reap)),
+        options_(options),
+        worker_(std::make_unique<BackgroundWorker>([this] { return Step(); },
+                                                   options_.interval)) {}
+
+  TtlReaper(const TtlReaper&) = delete;
+  TtlReaper& operator=(const TtlReaper&) = delete;
+
+  ~TtlReaper() { worker_->Stop(); }
+
+  /// Reap as soon as possible instead of waiting for the interval.
+  void Wake() { worker_->Wake(); }
+
+ private:
+  /// Runs one batch. Returns true if there may be more work right away.
+  bool Step() {
+    const auto limit = std::max<std::size_t>(options_.batch_size, 1);
+
+    return reap_(limit) >= limit;
+  }
+
+  ReapFn reap_;
+  TtlReaperOptions options_;
+  std::unique_ptr<BackgroundWorker> worker_;
+};
+
+}  // namespace boltdb
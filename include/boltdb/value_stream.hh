@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+#include "boltdb/bucket.hh"
+#include "boltdb/errors.hh"
+#include "boltdb/node.hh"
+#include "boltdb/page.hh"
+
+namespace boltdb {
+
+/// \brief ValueWriter assembles a value of a size declared up front from
+///        chunks, the building block of Bucket::PutStream().
+///
+/// This does not stream: nothing reaches the overflow pages as it arrives.
+/// A leaf value lives in the leaf's own page run, at an offset fixed only
+/// once the whole node is laid out, and nothing here can reserve that run
+/// ahead of the write. The whole value is therefore held in the node, and
+/// Node::Write() copies it into the page buffer as it does for Put(); a
+/// multi-MB value still peaks at two copies while the node is written.
+/// All the writer spares is a contiguous buffer on the caller's side:
+/// chunks go into one buffer reserved at the declared size, which is moved
+/// into the node on Commit().
+///
+/// Nothing is visible in the node until Commit(); a writer destroyed or
+/// moved from before that leaves the node unchanged.
+class ValueWriter {
+ public:
+  /// Starts a value of exactly `size` bytes under `key` in `node`. Throws
+  /// kKeyRequired, kKeyTooLarge or kValueTooLarge.
+  ValueWriter(Node& node, std::span<const std::byte> key, std::size_t size)
+      : node_(&node), key_(key.begin(), key.end()) {
+    assert(node.IsLeaf());
+
+    if (key.empty()) ThrowError(Errc::kKeyRequired);
+    if (key.size() > kMaxKeySize) ThrowError(Errc::kKeyTooLarge);
+    if (size > kMaxValueSize) ThrowError(Errc::kValueTooLarge);
+
+    value_.reserve(size);
+    size_ = size;
+  }
+
+  ValueWriter(ValueWriter&& other) noexcept
+      : node_(std::exchange(other.node_, nullptr)),
+        key_(std::move(other.key_)),
+        value_(std::move(other.value_)),
+        size_(std::exchange(other.size_, 0)) {}
+
+  ValueWriter& operator=(ValueWriter&& other) noexcept {
+    node_ = std::exchange(other.node_, nullptr);
+    key_ = std::move(other.key_);
+    value_ = std::move(other.value_);
+    size_ = std::exchange(other.size_, 0);
+
+    return *this;
+  }
+
+  /// Appends `chunk`. Throws kValueSizeMismatch if it runs past the
+  /// declared size.
+  void Write(std::span<const std::byte> chunk) {
+    if (chunk.size() > Remaining()) ThrowError(Errc::kValueSizeMismatch);
+
+    value_.insert(value_.end(), chunk.begin(), chunk.end());
+  }
+
+  /// Bytes still expected before Commit().
+  [[nodiscard]] std::size_t Remaining() const noexcept {
+    return size_ - value_.size();
+  }
+
+  /// Stores the value in the node. Throws kValueSizeMismatch if fewer bytes
+  /// than declared were written.
+  void Commit() {
+    assert(node_ != nullptr && "commit: writer already committed");
+    if (Remaining() != 0) ThrowError(Errc::kValueSizeMismatch);
+
+    node_->PutOwned(key_, key_, std::move(value_), PageId{0}, LeafFlag::kNone);
+    node_ = nullptr;
+  }
+
+ private:
+  Node* node_;
+  std::vector<std::byte> key_;
+  std::vector<std::byte> value_;
+  std::size_t size_ = 0;
+};
+
+/// \brief ValueChunks reads a leaf value in pieces that each stay within
+///        one page of the element's overflow run, the building block of
+///        Bucket::GetStream().
+///
+/// Chunks are views into the page, nothing is copied. On a memory-mapped
+/// file each chunk touches a single page, so a reader handing chunks to a
+/// socket faults the value in page by page instead of all at once.
+class ValueChunks {
+ public:
+  /// Reads the value of leaf element `index` of `p`, which starts a run of
+  /// `p.overflow + 1` pages of `page_size` bytes.
+  ValueChunks(const Page& p, std::uint16_t index, std::size_t page_size)
+      : base_(reinterpret_cast<const std::byte*>(&p)),
+        page_size_(page_size),
+        rest_(p.GetLeafElement(index).Value()) {
+    assert(page_size > 0);
+  }
+
+  /// Returns the next chunk, or nothing once the value is consumed.
+  std::optional<std::span<const std::byte>> Next() {
+    if (rest_.empty()) return std::nullopt;
+
+    // Cut at the end of the page holding the first byte.
+    const auto offset = static_cast<std::size_t>(rest_.data() - base_);
+    const auto n = std::min(rest_.size(), page_size_ - offset % page_size_);
+    const auto chunk = rest_.first(n);
+    rest_ = rest_.subspan(n);
+
+    return chunk;
+  }
+
+  /// Bytes not yet returned.
+  [[nodiscard]] std::size_t Remaining() const noexcept { return rest_.size(); }
+
+ private:
+  const std::byte* base_;
+  std::size_t page_size_;
+  std::span<const std::byte> rest_;
+};
+
+}  // namespace boltdb
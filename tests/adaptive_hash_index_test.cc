@@ -0,0 +1,88 @@
+#include "adaptive_hash_index.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <string_view>
+
+#include "node.hh"
+#include "test_util.hh"
+
+namespace boltdb {
+
+class AdaptiveHashIndexTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    Node n(true);
+    for (auto key : {"apple", "banana", "cherry"}) {
+      n.Put(AsBytes(key), AsBytes(key), AsBytes(std::string("v-") + key),
+            PageId{0}, LeafFlag::kNone);
+    }
+
+    buf = std::make_unique<std::byte[]>(4096);
+    std::memset(buf.get(), 0, 4096);
+    page = reinterpret_cast<Page*>(buf.get());
+    page->id = PageId{5};
+    n.Write(*page);
+
+    resolve = [this](PageId id) -> const Page* {
+      return id == PageId{5} ? page : nullptr;
+    };
+  }
+
+  std::unique_ptr<std::byte[]> buf;
+  Page* page = nullptr;
+  PageResolver resolve;
+};
+
+TEST_F(AdaptiveHashIndexTest, PromotesHotKeys) {
+  AdaptiveHashIndex index({.capacity = 64, .promote_after = 2});
+  EXPECT_FALSE(index.Get(AsBytes("banana"), 1, resolve).has_value());
+
+  index.Record(AsBytes("banana"), 1, PageId{5}, 1);
+  EXPECT_FALSE(index.Get(AsBytes("banana"), 1, resolve).has_value());
+
+  index.Record(AsBytes("banana"), 1, PageId{5}, 1);
+  auto got = index.Get(AsBytes("banana"), 1, resolve);
+  ASSERT_TRUE(got.has_value());
+  EXPECT_EQ(AsString(*got), "v-banana");
+  EXPECT_EQ(index.Hits(), 1);
+  EXPECT_EQ(index.Misses(), 2);
+}
+
+TEST_F(AdaptiveHashIndexTest, OnlyTrustedForSameTxid) {
+  AdaptiveHashIndex index({.capacity = 64, .promote_after = 1});
+  index.Record(AsBytes("cherry"), 7, PageId{5}, 2);
+  EXPECT_TRUE(index.Get(AsBytes("cherry"), 7, resolve).has_value());
+  EXPECT_FALSE(index.Get(AsBytes("cherry"), 8, resolve).has_value());
+
+  // A descent under the newer txid that finds the same position refreshes
+  // the entry.
+  index.Record(AsBytes("cherry"), 8, PageId{5}, 2);
+  EXPECT_TRUE(index.Get(AsBytes("cherry"), 8, resolve).has_value());
+  EXPECT_FALSE(index.Get(AsBytes("cherry"), 7, resolve).has_value());
+}
+
+TEST_F(AdaptiveHashIndexTest, ValidatesKeyAtSlot) {
+  AdaptiveHashIndex index({.capacity = 64, .promote_after = 1});
+
+  // A stale position (the key moved within the leaf) must not return the
+  // neighbouring value.
+  index.Record(AsBytes("apple"), 1, PageId{5}, 1);
+  EXPECT_FALSE(index.Get(AsBytes("apple"), 1, resolve).has_value());
+
+  // Out of range and unknown pages fall back as well.
+  index.Record(AsBytes("apple"), 1, PageId{5}, 9);
+  EXPECT_FALSE(index.Get(AsBytes("apple"), 1, resolve).has_value());
+  index.Record(AsBytes("apple"), 1, PageId{6}, 0);
+  EXPECT_FALSE(index.Get(AsBytes("apple"), 1, resolve).has_value());
+
+  index.Record(AsBytes("apple"), 1, PageId{5}, 0);
+  EXPECT_TRUE(index.Get(AsBytes("apple"), 1, resolve).has_value());
+
+  index.Clear();
+  EXPECT_FALSE(index.Get(AsBytes("apple"), 1, resolve).has_value());
+}
+
+}  // namespace boltdb
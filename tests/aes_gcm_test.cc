@@ -0,0 +1,119 @@
+#include "aes_gcm.hh"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace boltdb {
+
+std::vector<std::byte> FromHex(std::string_view hex) {
+  std::vector<std::byte> out;
+  for (std::size_t i = 0; i + 1 < hex.size(); i += 2) {
+    out.push_back(static_cast<std::byte>(
+        std::stoi(std::string(hex.substr(i, 2)), nullptr, 16)));
+  }
+  return out;
+}
+
+struct GcmVector {
+  const char* key;
+  const char* iv;
+  const char* aad;
+  const char* plaintext;
+  const char* ciphertext;
+  const char* tag;
+};
+
+constexpr const char* kKey128 = "feffe9928665731c6d6a8f9467308308";
+constexpr const char* kKey256 =
+    "feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308";
+constexpr const char* kAad = "feedfacedeadbeeffeedfacedeadbeefabaddad2";
+constexpr const char* kPlaintext =
+    "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+    "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39";
+
+// Test cases 1-6, 13, 14 and 16 of the GCM specification (McGrew & Viega).
+const GcmVector kVectors[] = {
+    {"00000000000000000000000000000000", "000000000000000000000000", "", "",
+     "", "58e2fccefa7e3061367f1d57a4e7455a"},
+    {"00000000000000000000000000000000", "000000000000000000000000", "",
+     "00000000000000000000000000000000", "0388dace60b6a392f328c2b971b2fe78",
+     "ab6e47d42cec13bdf53a67b21257bddf"},
+    {kKey128, "cafebabefacedbaddecaf888", "",
+     "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a72"
+     "1c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b391aafd255",
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+     "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091473f5985",
+     "4d5c2af327cd64a62cf35abd2ba6fab4"},
+    {kKey128, "cafebabefacedbaddecaf888", kAad, kPlaintext,
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e"
+     "21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+     "5bc94fbc3221a5db94fae95ae7121a47"},
+    {kKey128, "cafebabefacedbad", kAad, kPlaintext,
+     "61353b4c2806934a777ff51fa22a4755699b2a714fcdc6f83766e5f97b6c7423"
+     "73806900e49f24b22b097544d4896b424989b5e1ebac0f07c23f4598",
+     "3612d2e79e3b0785561be14aaca2fccb"},
+    {kKey128,
+     "9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728"
+     "c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b",
+     kAad, kPlaintext,
+     "8ce24998625615b603a033aca13fb894be9112a5c3a211a8ba262a3cca7e2ca7"
+     "01e4a9a4fba43c90ccdcb281d48c7c6fd62875d2aca417034c34aee5",
+     "619cc5aefffe0bfa462af43c1699d050"},
+    {"0000000000000000000000000000000000000000000000000000000000000000",
+     "000000000000000000000000", "", "", "",
+     "530f8afbc74536b9a963b4f1c4cb738b"},
+    {"0000000000000000000000000000000000000000000000000000000000000000",
+     "000000000000000000000000", "", "00000000000000000000000000000000",
+     "cea7403d4d606b6e074ec5d3baf39d18", "d0d1c8a799996bf0265b98b5d48ab919"},
+    {kKey256, "cafebabefacedbaddecaf888", kAad, kPlaintext,
+     "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa"
+     "8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662",
+     "76fc6ece0f4e1768cddf8853bb2d551b"},
+};
+
+TEST(AesGcmTest, SpecVectors) {
+  for (const auto& v : kVectors) {
+    const AesGcm gcm(FromHex(v.key));
+    auto data = FromHex(v.plaintext);
+    const auto tag = gcm.Seal(FromHex(v.iv), FromHex(v.aad), data);
+
+    EXPECT_EQ(data, FromHex(v.ciphertext)) << v.ciphertext;
+    EXPECT_EQ(std::vector(tag.begin(), tag.end()), FromHex(v.tag)) << v.tag;
+
+    ASSERT_TRUE(gcm.Open(FromHex(v.iv), FromHex(v.aad), data, tag));
+    EXPECT_EQ(data, FromHex(v.plaintext));
+  }
+}
+
+TEST(AesGcmTest, RejectsTampering) {
+  const AesGcm gcm(FromHex(kKey128));
+  const auto iv = FromHex("cafebabefacedbaddecaf888");
+  auto data = FromHex(kPlaintext);
+  const auto tag = gcm.Seal(iv, FromHex(kAad), data);
+
+  // A rejected open leaves the ciphertext as it was.
+  auto flipped = data;
+  flipped[5] ^= std::byte{1};
+  const auto before = flipped;
+  EXPECT_FALSE(gcm.Open(iv, FromHex(kAad), flipped, tag));
+  EXPECT_EQ(flipped, before);
+
+  auto copy = data;
+  EXPECT_FALSE(gcm.Open(iv, FromHex("00"), copy, tag));
+  EXPECT_EQ(copy, data);
+}
+
+TEST(AesGcmKeyTest, InvalidKey) {
+  try {
+    AesGcm gcm(FromHex("0011"));
+    FAIL() << "short key accepted";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code(), Errc::kInvalidKey);
+  }
+}
+
+}  // namespace boltdb
@@ -0,0 +1,130 @@
+#include "async_get.hh"
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+
+#include <filesystem>
+#include <format>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "node.hh"
+#include "test_util.hh"
+
+namespace boltdb {
+
+constexpr std::size_t kPageSize = 4096;
+
+class AsyncGetTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+    path_ = std::filesystem::temp_directory_path() /
+            (std::string("boltdb_async_get_") + info->name());
+
+    // A branch root at page 1 over 20 leaves of 10 keys each.
+    File file(path_, O_RDWR | O_CREAT | O_TRUNC);
+    Node root(false);
+    for (int i = 0; i < 20; ++i) {
+      Node leaf(true);
+      for (int j = 0; j < 10; ++j) {
+        const auto key = Key(i * 10 + j);
+        leaf.Put(AsBytes(key), AsBytes(key), AsBytes("v" + key), PageId{0},
+                 LeafFlag::kNone);
+      }
+      const PageId id{static_cast<std::uint64_t>(i) + 2};
+      Write(file, id, leaf);
+
+      const auto first = Key(i * 10);
+      root.Put(AsBytes(first), AsBytes(first), {}, id, LeafFlag::kNone);
+    }
+    Write(file, root_, root);
+  }
+
+  void TearDown() override { std::filesystem::remove(path_); }
+
+  static std::string Key(int i) { return std::format("{:06d}", i); }
+
+  static void Write(File& file, PageId id, const Node& n) {
+    std::vector<std::byte> buf(kPageSize);
+    auto* p = reinterpret_cast<Page*>(buf.data());
+    p->id = id;
+    n.Write(*p);
+    file.WriteAt(buf, ToUint64(id) * kPageSize);
+  }
+
+  BufferPool Pool() { return BufferPool(File(path_, O_RDONLY)); }
+
+  std::filesystem::path path_;
+  PageId root_{1};
+};
+
+TEST_F(AsyncGetTest, ManyLookupsInFlight) {
+  auto pool = Pool();
+  IoLoop loop(8);
+
+  std::vector<std::string> keys;
+  for (int i = 0; i < 200; i += 3) keys.push_back(Key(i));
+  keys.push_back("999999");
+
+  std::vector<Task<std::optional<PinnedValue>>> tasks;
+  for (const auto& key : keys) {
+    tasks.push_back(GetAsync(loop, pool, root_, AsBytes(key)));
+    tasks.back().Start();
+  }
+  // At least one read per leaf is outstanding before the loop runs.
+  EXPECT_GE(loop.InFlight(), 20);
+  loop.Run();
+
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    ASSERT_TRUE(tasks[i].Done());
+    const auto& got = tasks[i].Result();
+    if (keys[i] == "999999") {
+      EXPECT_FALSE(got.has_value());
+      continue;
+    }
+    ASSERT_TRUE(got.has_value()) << keys[i];
+    EXPECT_EQ(AsString(got->value), "v" + keys[i]);
+  }
+  EXPECT_EQ(pool.Misses(), 21);
+}
+
+TEST_F(AsyncGetTest, CachedLookupDoesNotSuspend) {
+  auto pool = Pool();
+  IoLoop loop(1);
+  const auto key = Key(42);
+
+  auto cold = GetAsync(loop, pool, root_, AsBytes(key));
+  cold.Start();
+  EXPECT_FALSE(cold.Done());
+  loop.Run();
+  ASSERT_TRUE(cold.Done());
+
+  auto warm = GetAsync(loop, pool, root_, AsBytes(key));
+  warm.Start();
+  ASSERT_TRUE(warm.Done());
+  EXPECT_EQ(loop.InFlight(), 0);
+  ASSERT_TRUE(warm.Result().has_value());
+  EXPECT_EQ(AsString(warm.Result()->value), "v000042");
+}
+
+TEST_F(AsyncGetTest, ReadErrorPropagates) {
+  auto pool = Pool();
+  IoLoop loop(1);
+
+  auto task = GetAsync(loop, pool, PageId{100}, AsBytes("x"));
+  task.Start();
+  loop.Run();
+  ASSERT_TRUE(task.Done());
+  try {
+    task.Result();
+    FAIL() << "expected a missing page";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code(), Errc::kPageOutOfRange);
+  }
+}
+
+}  // namespace boltdb
@@ -0,0 +1,134 @@
+#include "blob_log.hh"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <map>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "test_util.hh"
+
+namespace boltdb {
+
+class BlobLogTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+    dir_ = std::filesystem::temp_directory_path() /
+           (std::string("boltdb_blob_log_") + info->name());
+    std::filesystem::remove_all(dir_);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir_); }
+
+  std::filesystem::path dir_;
+};
+
+TEST_F(BlobLogTest, AppendRead) {
+  BlobLog log(dir_);
+  const auto a = log.Append(AsBytes("a"), AsBytes("hello"));
+  const auto b = log.Append(AsBytes("b"), AsBytes(std::string(10000, 'x')));
+
+  EXPECT_EQ(AsString(log.Read(a)), "hello");
+  EXPECT_EQ(AsString(log.Read(b)), std::string(10000, 'x'));
+  EXPECT_EQ(BlobPointer::Decode(b.Encode()), b);
+}
+
+TEST_F(BlobLogTest, SeparatedValues) {
+  BlobLog log(dir_, BlobLogOptions{.threshold = 16});
+  Node n(true);
+  const std::string big(100, 'v');
+  PutSeparated(n, log, AsBytes("big"), AsBytes(big));
+  PutSeparated(n, log, AsBytes("small"), AsBytes("s"));
+
+  const auto& inodes = n.GetInodes();
+  ASSERT_EQ(inodes.size(), 2);
+  EXPECT_EQ(inodes[0].flags, LeafFlag::kBlobRef);
+  EXPECT_EQ(inodes[0].Value().size(), BlobPointer::kEncodedSize);
+  EXPECT_EQ(inodes[1].flags, LeafFlag::kNone);
+
+  EXPECT_EQ(AsString(LoadValue(log, inodes[0].flags, inodes[0].Value())), big);
+  EXPECT_EQ(AsString(LoadValue(log, inodes[1].flags, inodes[1].Value())), "s");
+}
+
+TEST_F(BlobLogTest, RollsSegments) {
+  BlobLog log(dir_, BlobLogOptions{.segment_size = 64});
+  std::vector<BlobPointer> ptrs;
+  for (int i = 0; i < 10; ++i) {
+    ptrs.push_back(log.Append(AsBytes("k"), AsBytes(std::string(40, 'a' + i))));
+  }
+
+  EXPECT_EQ(log.Segments().size(), 10);
+  for (int i = 0; i < 10; ++i) {
+    EXPECT_EQ(AsString(log.Read(ptrs[i])), std::string(40, 'a' + i));
+  }
+}
+
+TEST_F(BlobLogTest, CollectAndDrop) {
+  BlobLog log(dir_);
+  std::map<std::string, BlobPointer> tree;
+  for (const auto* key : {"a", "b", "c", "d"}) {
+    tree[key] = log.Append(AsBytes(key), AsBytes(std::string(key) + "-v1"));
+  }
+  // Overwrite two keys; their first records are dead.
+  tree["b"] = log.Append(AsBytes("b"), AsBytes("b-v2"));
+  tree["d"] = log.Append(AsBytes("d"), AsBytes("d-v2"));
+
+  const auto segment = log.Segments().front();
+  const auto moved = log.Collect(
+      segment,
+      [&](auto key, const BlobPointer& ptr) {
+        return tree.at(std::string(AsString(key))) == ptr;
+      },
+      [&](auto key, const BlobPointer&, const BlobPointer& to) {
+        tree[std::string(AsString(key))] = to;
+      });
+  EXPECT_EQ(moved, 4);
+
+  log.Drop(segment);
+  EXPECT_EQ(log.Segments(), std::vector<std::uint32_t>{segment + 1});
+  EXPECT_EQ(AsString(log.Read(tree["a"])), "a-v1");
+  EXPECT_EQ(AsString(log.Read(tree["b"])), "b-v2");
+  EXPECT_EQ(AsString(log.Read(tree["c"])), "c-v1");
+  EXPECT_EQ(AsString(log.Read(tree["d"])), "d-v2");
+}
+
+TEST_F(BlobLogTest, ReopenCutsTornTail) {
+  BlobPointer ptr;
+  {
+    BlobLog log(dir_);
+    ptr = log.Append(AsBytes("k"), AsBytes("value"));
+    log.Append(AsBytes("torn"), AsBytes("lost"));
+    log.Sync();
+  }
+  const auto path = dir_ / "000001.blob";
+  const auto full = std::filesystem::file_size(path);
+  std::filesystem::resize_file(path, full - 2);
+
+  BlobLog log(dir_);
+  EXPECT_EQ(std::filesystem::file_size(path), ptr.offset + ptr.length);
+  EXPECT_EQ(AsString(log.Read(ptr)), "value");
+
+  // New appends continue where the intact records end.
+  const auto next = log.Append(AsBytes("n"), AsBytes("next"));
+  EXPECT_EQ(AsString(log.Read(next)), "next");
+  EXPECT_EQ(AsString(log.Read(ptr)), "value");
+}
+
+TEST_F(BlobLogTest, ChecksumMismatch) {
+  BlobLog log(dir_);
+  auto ptr = log.Append(AsBytes("k"), AsBytes("value"));
+  ++ptr.checksum;
+
+  try {
+    (void)log.Read(ptr);
+    FAIL() << "damaged value returned";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code(), Errc::kChecksumMismatch);
+  }
+}
+
+}  // namespace boltdb
@@ -0,0 +1,232 @@
+#include "buffer_pool.hh"
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+
+#include <filesystem>
+#include <format>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "cursor.hh"
+#include "node.hh"
+#include "test_util.hh"
+
+namespace boltdb {
+
+constexpr std::size_t kPageSize = 4096;
+
+class BufferPoolTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+    path_ = std::filesystem::temp_directory_path() /
+            (std::string("boltdb_buffer_pool_") + info->name());
+    std::filesystem::remove(path_);
+    file_ = File(path_, O_RDWR | O_CREAT);
+  }
+
+  void TearDown() override {
+    file_.Close();
+    std::filesystem::remove(path_);
+  }
+
+  /// Writes `n` as page `id`, spilling into overflow pages if needed.
+  void WritePage(PageId id, const Node& n) {
+    const auto pages = (n.Size() + kPageSize - 1) / kPageSize;
+    std::vector<std::byte> buf(pages * kPageSize);
+    auto* p = reinterpret_cast<Page*>(buf.data());
+    p->id = id;
+    p->overflow = static_cast<std::uint32_t>(pages - 1);
+    n.Write(*p);
+    file_.WriteAt(buf, ToUint64(id) * kPageSize);
+  }
+
+  /// Writes a branch root at page 1 over `leaves` leaves of 10 keys each,
+  /// at pages 2 and up. Returns the root.
+  PageId WriteTree(int leaves) {
+    Node root(false);
+    for (int i = 0; i < leaves; ++i) {
+      Node leaf(true);
+      for (int j = 0; j < 10; ++j) {
+        const auto key = std::format("{:06d}", i * 10 + j);
+        leaf.Put(AsBytes(key), AsBytes(key), AsBytes("v" + key), PageId{0},
+                 LeafFlag::kNone);
+      }
+      const PageId id{static_cast<std::uint64_t>(i) + 2};
+      WritePage(id, leaf);
+
+      const auto first = std::format("{:06d}", i * 10);
+      root.Put(AsBytes(first), AsBytes(first), {}, id, LeafFlag::kNone);
+    }
+    WritePage(PageId{1}, root);
+
+    return PageId{1};
+  }
+
+  BufferPool Pool(std::size_t pages) {
+    return BufferPool(File(path_, O_RDONLY),
+                      BufferPoolOptions{.capacity = pages * kPageSize});
+  }
+
+  std::filesystem::path path_;
+  File file_;
+};
+
+TEST_F(BufferPoolTest, FetchCachesPages) {
+  WriteTree(3);
+  auto pool = Pool(16);
+
+  {
+    const auto p = pool.Fetch(PageId{2});
+    EXPECT_EQ(p->id, PageId{2});
+    EXPECT_TRUE(p->IsLeaf());
+  }
+  const auto p = pool.Fetch(PageId{2});
+  EXPECT_EQ(p->count, 10);
+
+  EXPECT_EQ(pool.Misses(), 1);
+  EXPECT_EQ(pool.Hits(), 1);
+  EXPECT_EQ(pool.Used(), kPageSize);
+}
+
+TEST_F(BufferPoolTest, OverflowRun) {
+  Node n(true);
+  const std::string big(3 * kPageSize, 'x');
+  n.Put(AsBytes("big"), AsBytes("big"), AsBytes(big), PageId{0},
+        LeafFlag::kNone);
+  WritePage(PageId{1}, n);
+  auto pool = Pool(16);
+
+  const auto p = pool.Fetch(PageId{1});
+  EXPECT_EQ(p->overflow, 3);
+  EXPECT_EQ(AsString(p->GetLeafElement(0).Value()), big);
+  EXPECT_EQ(pool.Used(), 4 * kPageSize);
+}
+
+TEST_F(BufferPoolTest, BranchPagesOutliveLeaves) {
+  const auto root = WriteTree(8);
+  auto pool = Pool(3);
+
+  // A lookup pattern: the root, then one leaf, for every leaf in turn.
+  for (int round = 0; round < 2; ++round) {
+    for (std::uint64_t leaf = 2; leaf < 10; ++leaf) {
+      pool.Fetch(root);
+      pool.Fetch(PageId{leaf});
+    }
+  }
+
+  EXPECT_EQ(pool.Misses(), 1 + 16);
+  EXPECT_GT(pool.Evictions(), 0);
+  EXPECT_LE(pool.Used(), 3 * kPageSize);
+}
+
+TEST_F(BufferPoolTest, PinnedPagesAreNotEvicted) {
+  WriteTree(3);
+  auto pool = Pool(2);
+
+  const auto a = pool.Fetch(PageId{2});
+  const auto b = pool.Fetch(PageId{3});
+  try {
+    pool.Fetch(PageId{4});
+    FAIL() << "expected an exhausted pool";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code(), Errc::kPoolExhausted);
+  }
+  EXPECT_EQ(a->id, PageId{2});
+  EXPECT_EQ(b->id, PageId{3});
+}
+
+TEST_F(BufferPoolTest, UnpinnedPagesAreReused) {
+  WriteTree(3);
+  auto pool = Pool(2);
+
+  for (std::uint64_t id = 2; id < 5; ++id) {
+    EXPECT_EQ(pool.Fetch(PageId{id})->id, PageId{id});
+  }
+  EXPECT_EQ(pool.Evictions(), 1);
+}
+
+TEST_F(BufferPoolTest, PastEndOfFile) {
+  WriteTree(1);
+  auto pool = Pool(4);
+
+  try {
+    pool.Fetch(PageId{10});
+    FAIL() << "expected a missing page";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code(), Errc::kPageOutOfRange);
+  }
+  EXPECT_EQ(pool.Used(), 0);
+}
+
+TEST_F(BufferPoolTest, CorruptOverflow) {
+  WriteTree(2);
+  std::vector<std::byte> buf(kPageSize);
+  auto* p = reinterpret_cast<Page*>(buf.data());
+  p->id = PageId{4};
+  p->overflow = 1000000;
+  file_.WriteAt(buf, 4 * kPageSize);
+
+  auto pool = Pool(4);
+  pool.Fetch(PageId{2});
+  pool.Fetch(PageId{3});
+  try {
+    pool.Fetch(PageId{4});
+    FAIL() << "expected a run past the end of the file";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code(), Errc::kPageOutOfRange);
+  }
+
+  // Nothing was evicted to make room for it.
+  EXPECT_EQ(pool.Evictions(), 0);
+  pool.Fetch(PageId{2});
+  EXPECT_EQ(pool.Hits(), 1);
+}
+
+TEST_F(BufferPoolTest, CursorThroughPinnedPath) {
+  const auto root = WriteTree(5);
+  auto pool = Pool(8);
+
+  PinnedPath path(pool);
+  Cursor c(path.Resolver(), root);
+  int i = 0;
+  for (auto kv = c.First(); kv; kv = c.Next(), ++i) {
+    EXPECT_EQ(AsString(kv->key), std::format("{:06d}", i));
+  }
+  EXPECT_EQ(i, 50);
+  EXPECT_EQ(pool.Misses(), 6);
+  EXPECT_EQ(path.Pinned(), 2);
+
+  const auto kv = c.Seek(AsBytes("000023"));
+  ASSERT_TRUE(kv.has_value());
+  EXPECT_EQ(AsString(kv->value), "v000023");
+  EXPECT_EQ(pool.Misses(), 6);
+}
+
+TEST_F(BufferPoolTest, ScanLargerThanCapacity) {
+  const auto root = WriteTree(40);
+  auto pool = Pool(4);
+
+  // Only the root and the current leaf are pinned, so leaves already
+  // passed are evicted to make room for the next.
+  PinnedPath path(pool);
+  Cursor c(path.Resolver(), root);
+  int i = 0;
+  for (auto kv = c.First(); kv; kv = c.Next(), ++i) {
+    ASSERT_EQ(AsString(kv->key), std::format("{:06d}", i));
+    ASSERT_LE(path.Pinned(), 2);
+  }
+  EXPECT_EQ(i, 400);
+  EXPECT_GT(pool.Evictions(), 0);
+  EXPECT_LE(pool.Used(), 4 * kPageSize);
+
+  // Scanning backwards works the same way.
+  for (auto kv = c.Last(); kv; kv = c.Prev()) --i;
+  EXPECT_EQ(i, 0);
+}
+
+}  // namespace boltdb
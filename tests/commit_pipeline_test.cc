@@ -0,0 +1,215 @@
+#include "commit_pipeline.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <chrono>
+#include <coroutine>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace boltdb {
+
+/// Stages that record the metas written and can hold the first sync.
+class FakeDisk {
+ public:
+  CommitStages Stages() {
+    return {
+        .sync =
+            [this] {
+              if (syncs_++ == 0) gate_.wait();
+              if (fail_at_ == syncs_) throw std::runtime_error("sync failed");
+            },
+        .write_meta =
+            [this](TransactionID txid) {
+              std::lock_guard lock(mu_);
+              metas_.push_back(txid);
+            },
+    };
+  }
+
+  void Release() { release_.set_value(); }
+
+  void FailAt(int sync) { fail_at_ = sync; }
+
+  std::vector<TransactionID> Metas() {
+    std::lock_guard lock(mu_);
+    return metas_;
+  }
+
+ private:
+  std::promise<void> release_;
+  std::shared_future<void> gate_ = release_.get_future().share();
+  int syncs_ = 0;
+  int fail_at_ = 0;
+  std::mutex mu_;
+  std::vector<TransactionID> metas_;
+};
+
+/// A coroutine that starts at once and is never awaited.
+struct Detached {
+  struct promise_type {
+    Detached get_return_object() { return {}; }
+    std::suspend_never initial_suspend() noexcept { return {}; }
+    std::suspend_never final_suspend() noexcept { return {}; }
+    void return_void() {}
+    void unhandled_exception() { std::terminate(); }
+  };
+};
+
+/// Commits `txid`, then acknowledges once it is durable.
+Detached CommitAndAck(CommitPipeline& pipeline, TransactionID txid,
+                      std::promise<bool>& ack) {
+  try {
+    co_await pipeline.CommitAsync(txid);
+    ack.set_value(true);
+  } catch (const std::runtime_error&) {
+    ack.set_value(false);
+  }
+}
+
+TEST(CommitPipelineTest, SubmitDoesNotWaitForSync) {
+  FakeDisk disk;
+  CommitPipeline pipeline(disk.Stages());
+
+  pipeline.Submit(1);
+  EXPECT_EQ(pipeline.Submitted(), 1);
+  EXPECT_EQ(pipeline.Durable(), 0);
+
+  disk.Release();
+  pipeline.WaitDurable(1);
+  EXPECT_EQ(pipeline.Durable(), 1);
+  EXPECT_EQ(disk.Metas(), std::vector<TransactionID>{1});
+}
+
+TEST(CommitPipelineTest, QueuedCommitsShareOneSync) {
+  FakeDisk disk;
+  CommitPipeline pipeline(disk.Stages());
+
+  // Commits 2-4 are built while commit 1 is still syncing.
+  pipeline.Submit(1);
+  pipeline.Submit(2);
+  pipeline.Submit(3);
+  pipeline.Submit(4);
+  EXPECT_EQ(pipeline.Durable(), 0);
+
+  disk.Release();
+  pipeline.Flush();
+  EXPECT_EQ(pipeline.Durable(), 4);
+
+  const auto metas = disk.Metas();
+  ASSERT_FALSE(metas.empty());
+  EXPECT_TRUE(std::is_sorted(metas.begin(), metas.end()));
+  EXPECT_EQ(metas.back(), 4);
+  EXPECT_LE(metas.size(), 2);
+}
+
+TEST(CommitPipelineTest, FailureStopsThePipeline) {
+  FakeDisk disk;
+  disk.FailAt(2);
+  disk.Release();
+  CommitPipeline pipeline(disk.Stages());
+
+  pipeline.Submit(1);
+  pipeline.WaitDurable(1);
+  pipeline.Submit(2);
+  EXPECT_THROW(pipeline.WaitDurable(2), std::runtime_error);
+  EXPECT_EQ(pipeline.Durable(), 1);
+  EXPECT_THROW(pipeline.Submit(3), std::runtime_error);
+}
+
+TEST(CommitPipelineTest, VisibleAfterDurableByDefault) {
+  FakeDisk disk;
+  CommitPipeline pipeline(disk.Stages());
+
+  pipeline.Submit(1);
+  EXPECT_EQ(pipeline.Visible(), 0);
+  disk.Release();
+  pipeline.Flush();
+  EXPECT_EQ(pipeline.Visible(), 1);
+}
+
+TEST(CommitPipelineTest, ImmediateVisibility) {
+  FakeDisk disk;
+  CommitPipeline pipeline(disk.Stages());
+
+  const auto durable = pipeline.CommitAsync(1);
+  EXPECT_EQ(pipeline.Visible(), 1);
+  EXPECT_FALSE(durable.Ready());
+
+  disk.Release();
+  durable.Wait();
+  EXPECT_TRUE(durable.Ready());
+  EXPECT_EQ(pipeline.Durable(), 1);
+}
+
+TEST(CommitPipelineTest, DurableOnlyVisibility) {
+  FakeDisk disk;
+  CommitPipeline pipeline(disk.Stages());
+
+  const auto durable = pipeline.CommitAsync(1, CommitVisibility::kDurable);
+  EXPECT_EQ(pipeline.Visible(), 0);
+
+  disk.Release();
+  durable.Wait();
+  EXPECT_EQ(pipeline.Visible(), 1);
+}
+
+TEST(CommitPipelineTest, FailureHidesUndurableCommits) {
+  FakeDisk disk;
+  disk.FailAt(2);
+  disk.Release();
+  CommitPipeline pipeline(disk.Stages());
+
+  pipeline.CommitAsync(1).Wait();
+  const auto failed = pipeline.CommitAsync(2);
+  EXPECT_THROW(failed.Wait(), std::runtime_error);
+  EXPECT_EQ(pipeline.Visible(), 1);
+}
+
+TEST(CommitPipelineTest, AwaitDurability) {
+  FakeDisk disk;
+  CommitPipeline pipeline(disk.Stages());
+
+  std::promise<bool> first;
+  std::promise<bool> second;
+  auto acked1 = first.get_future();
+  auto acked2 = second.get_future();
+  CommitAndAck(pipeline, 1, first);
+  CommitAndAck(pipeline, 2, second);
+  EXPECT_EQ(pipeline.Visible(), 2);
+  EXPECT_EQ(acked1.wait_for(std::chrono::milliseconds(10)),
+            std::future_status::timeout);
+
+  disk.Release();
+  EXPECT_TRUE(acked1.get());
+  EXPECT_TRUE(acked2.get());
+  EXPECT_EQ(pipeline.Durable(), 2);
+}
+
+TEST(CommitPipelineTest, AwaitFailure) {
+  FakeDisk disk;
+  disk.FailAt(1);
+  CommitPipeline pipeline(disk.Stages());
+
+  std::promise<bool> ack;
+  auto acked = ack.get_future();
+  CommitAndAck(pipeline, 1, ack);
+  disk.Release();
+  EXPECT_FALSE(acked.get());
+}
+
+TEST(CommitPipelineTest, DestructorFlushes) {
+  FakeDisk disk;
+  disk.Release();
+  {
+    CommitPipeline pipeline(disk.Stages(), 4);
+    pipeline.Submit(5);
+  }
+  EXPECT_EQ(disk.Metas(), std::vector<TransactionID>{5});
+}
+
+}  // namespace boltdb
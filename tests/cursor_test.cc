@@ -0,0 +1,215 @@
+#include "cursor.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <format>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "delta_leaf.hh"
+#include "node.hh"
+#include "test_util.hh"
+
+namespace boltdb {
+
+std::string Key(int i) { return std::format("{:06d}", i); }
+
+/// Builds a read-only B+tree of `keys` with `fanout` entries per page and
+/// counts page resolutions.
+class TestTree {
+ public:
+  TestTree(const std::vector<std::string>& keys, std::size_t fanout) {
+    struct Child {
+      std::string key;
+      PageId pgid;
+    };
+    std::vector<Child> level;
+
+    for (std::size_t i = 0; i < keys.size() || i == 0; i += fanout) {
+      Node n(true);
+      for (std::size_t j = i; j < std::min(i + fanout, keys.size()); ++j) {
+        n.Put(AsBytes(keys[j]), AsBytes(keys[j]), AsBytes("v" + keys[j]),
+              PageId{0}, LeafFlag::kNone);
+      }
+      level.push_back({i < keys.size() ? keys[i] : "", Write(n)});
+    }
+
+    while (level.size() > 1) {
+      std::vector<Child> parents;
+      for (std::size_t i = 0; i < level.size(); i += fanout) {
+        Node n(false);
+        for (std::size_t j = i; j < std::min(i + fanout, level.size()); ++j) {
+          n.Put(AsBytes(level[j].key), AsBytes(level[j].key), {}, level[j].pgid,
+                LeafFlag::kNone);
+        }
+        parents.push_back({level[i].key, Write(n)});
+      }
+      level = std::move(parents);
+    }
+
+    root = level.front().pgid;
+  }
+
+  Cursor NewCursor(KeySearch search = KeySearch::kBinary) {
+    return Cursor(
+        [this](PageId id) {
+          ++resolves;
+          return reinterpret_cast<const Page*>(pages.at(id).get());
+        },
+        root, search);
+  }
+
+  PageId root{};
+  std::size_t resolves = 0;
+
+ private:
+  PageId Write(const Node& n) {
+    const PageId id{pages.size() + 1};
+    auto buf = std::make_unique<std::byte[]>(n.Size());
+    auto* p = reinterpret_cast<Page*>(buf.get());
+    p->id = id;
+    n.Write(*p);
+    pages.emplace(id, std::move(buf));
+    return id;
+  }
+
+  std::map<PageId, std::unique_ptr<std::byte[]>> pages;
+};
+
+std::vector<std::string> EvenKeys(int n) {
+  std::vector<std::string> keys;
+  for (int i = 0; i < n; ++i) keys.push_back(Key(i * 2));
+  return keys;
+}
+
+TEST(CursorTest, Empty) {
+  TestTree tree({}, 4);
+  auto c = tree.NewCursor();
+  EXPECT_FALSE(c.First().has_value());
+  EXPECT_FALSE(c.Last().has_value());
+  EXPECT_FALSE(c.Seek(AsBytes("foo")).has_value());
+}
+
+TEST(CursorTest, IterateForwardAndReverse) {
+  const auto keys = EvenKeys(500);
+  TestTree tree(keys, 8);
+  auto c = tree.NewCursor();
+
+  std::vector<std::string> got;
+  for (auto kv = c.First(); kv; kv = c.Next()) {
+    got.emplace_back(AsString(kv->key));
+    EXPECT_EQ(AsString(kv->value), "v" + got.back());
+  }
+  EXPECT_EQ(got, keys);
+
+  got.clear();
+  for (auto kv = c.Last(); kv; kv = c.Prev()) {
+    got.emplace_back(AsString(kv->key));
+  }
+  std::reverse(got.begin(), got.end());
+  EXPECT_EQ(got, keys);
+}
+
+TEST(CursorTest, Seek) {
+  TestTree tree(EvenKeys(500), 8);
+  auto c = tree.NewCursor();
+
+  auto kv = c.Seek(AsBytes(Key(100)));
+  ASSERT_TRUE(kv.has_value());
+  EXPECT_EQ(AsString(kv->key), Key(100));
+
+  kv = c.Seek(AsBytes(Key(101)));
+  ASSERT_TRUE(kv.has_value());
+  EXPECT_EQ(AsString(kv->key), Key(102));
+
+  kv = c.Seek(AsBytes(""));
+  ASSERT_TRUE(kv.has_value());
+  EXPECT_EQ(AsString(kv->key), Key(0));
+
+  EXPECT_FALSE(c.Seek(AsBytes(Key(999))).has_value());
+
+  // The cursor can be walked from a seek position, and seeking backwards
+  // from there still works.
+  kv = c.Seek(AsBytes(Key(15)));
+  ASSERT_TRUE(kv.has_value());
+  EXPECT_EQ(AsString(c.Next()->key), Key(18));
+  EXPECT_EQ(AsString(c.Seek(AsBytes(Key(3)))->key), Key(4));
+  EXPECT_EQ(AsString(c.Prev()->key), Key(2));
+}
+
+TEST(CursorTest, FingerSeekMatchesFreshSeek) {
+  TestTree tree(EvenKeys(2000), 6);
+  auto finger = tree.NewCursor();
+  std::mt19937 gen(1);
+  std::uniform_int_distribution<int> dist(0, 4100);
+
+  for (int i = 0; i < 2000; ++i) {
+    const auto key = Key(dist(gen));
+    auto fresh = tree.NewCursor();
+    const auto want = fresh.Seek(AsBytes(key));
+    const auto got = finger.Seek(AsBytes(key));
+
+    ASSERT_EQ(want.has_value(), got.has_value()) << key;
+    if (want) {
+      ASSERT_EQ(AsString(want->key), AsString(got->key)) << key;
+      ASSERT_EQ(AsString(finger.Next().value_or(KeyValue{}).key),
+                AsString(fresh.Next().value_or(KeyValue{}).key));
+    }
+  }
+}
+
+TEST(CursorTest, InterpolationSearch) {
+  TestTree tree(EvenKeys(1000), 16);
+  auto c = tree.NewCursor(KeySearch::kInterpolation);
+
+  for (int i = 0; i < 2100; i += 7) {
+    auto fresh = tree.NewCursor();
+    const auto want = fresh.Seek(AsBytes(Key(i)));
+    const auto got = c.Seek(AsBytes(Key(i)));
+    ASSERT_EQ(want.has_value(), got.has_value());
+    if (want) {
+      EXPECT_EQ(AsString(want->key), AsString(got->key));
+    }
+  }
+}
+
+TEST(CursorTest, AscendingSeeksStayNearTheLeaf) {
+  TestTree tree(EvenKeys(4000), 8);  // 4 levels
+  auto c = tree.NewCursor();
+
+  c.Seek(AsBytes(Key(0)));
+  const auto before = tree.resolves;
+  for (int i = 1; i < 4000; ++i) {
+    auto kv = c.Seek(AsBytes(Key(i * 2)));
+    ASSERT_TRUE(kv.has_value());
+    ASSERT_EQ(AsString(kv->key), Key(i * 2));
+  }
+
+  // A root restart would resolve 4 pages per seek. Finger search only
+  // resolves when crossing into a new leaf (and the odd branch).
+  EXPECT_LT(tree.resolves - before, 4000 / 8 * 2);
+}
+
+TEST(CursorTest, RejectsDeltaLeaf) {
+  Inodes inodes(1);
+  inodes[0].key.assign(8, std::byte{0});
+  std::vector<std::byte> buf(DeltaLeafSize(inodes));
+  auto* p = reinterpret_cast<Page*>(buf.data());
+  WriteDeltaLeaf(inodes, *p);
+
+  Cursor c([p](PageId) { return p; }, PageId{1});
+  try {
+    c.First();
+    FAIL() << "expected an unsupported page";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code(), Errc::kUnsupportedPage);
+  }
+}
+
+}  // namespace boltdb
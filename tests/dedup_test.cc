@@ -0,0 +1,80 @@
+#include "dedup.hh"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+
+#include "test_util.hh"
+
+namespace boltdb {
+
+std::string_view Get(const Node& data, const Node& content,
+                     std::string_view key) {
+  const auto* inode = data.Find(AsBytes(key));
+  return AsString(LoadDeduped(content, inode->flags, inode->Value()));
+}
+
+TEST(DedupTest, SharesLargeValues) {
+  Node data(true);
+  Node content(true);
+  const std::string payload(2000, 'p');
+  const auto ref = ContentRef::Of(AsBytes(payload)).Encode();
+
+  PutDeduped(data, content, AsBytes("a"), AsBytes(payload));
+  PutDeduped(data, content, AsBytes("b"), AsBytes(payload));
+  PutDeduped(data, content, AsBytes("small"), AsBytes("tiny"));
+
+  EXPECT_EQ(content.Count(), 1);
+  EXPECT_EQ(ContentRefCount(content, ref), 2);
+  EXPECT_EQ(data.Find(AsBytes("a"))->flags, LeafFlag::kContentRef);
+  EXPECT_EQ(data.Find(AsBytes("small"))->flags, LeafFlag::kNone);
+  EXPECT_EQ(Get(data, content, "a"), payload);
+  EXPECT_EQ(Get(data, content, "b"), payload);
+  EXPECT_EQ(Get(data, content, "small"), "tiny");
+}
+
+TEST(DedupTest, ReleasesReferences) {
+  Node data(true);
+  Node content(true);
+  const std::string v1(2000, '1');
+  const std::string v2(2000, '2');
+
+  PutDeduped(data, content, AsBytes("a"), AsBytes(v1));
+  PutDeduped(data, content, AsBytes("b"), AsBytes(v1));
+
+  // Putting the same value again keeps the count.
+  PutDeduped(data, content, AsBytes("a"), AsBytes(v1));
+  EXPECT_EQ(ContentRefCount(content, ContentRef::Of(AsBytes(v1)).Encode()), 2);
+
+  // Overwriting and deleting release the old value.
+  PutDeduped(data, content, AsBytes("a"), AsBytes(v2));
+  EXPECT_EQ(ContentRefCount(content, ContentRef::Of(AsBytes(v1)).Encode()), 1);
+  DeleteDeduped(data, content, AsBytes("b"));
+  EXPECT_EQ(ContentRefCount(content, ContentRef::Of(AsBytes(v1)).Encode()), 0);
+  EXPECT_EQ(content.Count(), 1);
+  EXPECT_EQ(Get(data, content, "a"), v2);
+
+  DeleteDeduped(data, content, AsBytes("a"));
+  EXPECT_EQ(content.Count(), 0);
+  EXPECT_EQ(data.Count(), 0);
+}
+
+TEST(DedupTest, CollisionStoredInline) {
+  Node data(true);
+  Node content(true);
+  const std::string value(2000, 'v');
+  const auto ref = ContentRef::Of(AsBytes(value)).Encode();
+
+  // Plant different content under the value's hash.
+  std::vector<std::byte> other(8 + 10, std::byte{'x'});
+  StoreLittleEndian64(other.data(), 1);
+  content.Put(ref, ref, other, PageId{0}, LeafFlag::kNone);
+
+  PutDeduped(data, content, AsBytes("k"), AsBytes(value));
+  EXPECT_EQ(data.Find(AsBytes("k"))->flags, LeafFlag::kNone);
+  EXPECT_EQ(Get(data, content, "k"), value);
+  EXPECT_EQ(ContentRefCount(content, ref), 1);
+}
+
+}  // namespace boltdb
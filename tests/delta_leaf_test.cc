@@ -0,0 +1,148 @@
+#include "delta_leaf.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace boltdb {
+
+std::vector<std::byte> TimestampKey(std::uint64_t ts) {
+  std::vector<std::byte> key(8);
+  StoreBigEndian64(key.data(), ts);
+  return key;
+}
+
+Inodes MakeInodes(const std::vector<std::uint64_t>& keys) {
+  Inodes inodes;
+  for (auto k : keys) {
+    auto value = std::to_string(k);
+    auto& inode = inodes.emplace_back();
+    inode.key = TimestampKey(k);
+    inode.value.assign(reinterpret_cast<const std::byte*>(value.data()),
+                       reinterpret_cast<const std::byte*>(value.data()) +
+                           value.size());
+  }
+  return inodes;
+}
+
+class DeltaLeafTest : public ::testing::Test {
+ protected:
+  Page* Write(const Inodes& inodes) {
+    const auto size = DeltaLeafSize(inodes);
+    buf = std::make_unique<std::byte[]>(size);
+    std::memset(buf.get(), 0, size);
+    auto* p = reinterpret_cast<Page*>(buf.get());
+    WriteDeltaLeaf(inodes, *p);
+    return p;
+  }
+
+  void ExpectRoundTrip(const std::vector<std::uint64_t>& keys) {
+    const auto inodes = MakeInodes(keys);
+    ASSERT_TRUE(CanDeltaEncode(inodes));
+
+    DeltaLeafView view(*Write(inodes));
+    ASSERT_EQ(view.Count(), keys.size());
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      ASSERT_EQ(view.KeyAt(i), keys[i]) << i;
+      const auto value = view.ValueAt(i);
+      ASSERT_EQ(std::string(reinterpret_cast<const char*>(value.data()),
+                            value.size()),
+                std::to_string(keys[i]));
+    }
+  }
+
+  std::unique_ptr<std::byte[]> buf;
+};
+
+TEST_F(DeltaLeafTest, RegularTimestamps) {
+  std::vector<std::uint64_t> keys;
+  for (std::uint64_t i = 0; i < 1000; ++i) keys.push_back(1700000000000 + i);
+  ExpectRoundTrip(keys);
+
+  // A regular series packs into block heads only, far smaller than one
+  // element header plus key copy per entry.
+  const auto inodes = MakeInodes(keys);
+  EXPECT_LT(DeltaKeysSize(inodes) * 10,
+            keys.size() * (kLeafElementSize + 8));
+}
+
+TEST_F(DeltaLeafTest, IrregularKeys) {
+  std::mt19937_64 gen(7);
+  std::vector<std::uint64_t> keys;
+  std::uint64_t k = 0;
+  for (int i = 0; i < 700; ++i) {
+    k += 1 + gen() % 5000;
+    keys.push_back(k);
+  }
+  ExpectRoundTrip(keys);
+}
+
+TEST_F(DeltaLeafTest, ExtremeDeltas) {
+  ExpectRoundTrip({0, 1, UINT64_MAX / 2, UINT64_MAX - 1, UINT64_MAX});
+  ExpectRoundTrip({42});
+  ExpectRoundTrip({42, 43});
+}
+
+TEST_F(DeltaLeafTest, EveryWidth) {
+  // Deltas of up to `bits` bits give packed widths up to about bits + 2,
+  // on both sides of the widest vectorized unpack.
+  std::mt19937_64 gen(11);
+  for (unsigned bits = 1; bits <= 61; ++bits) {
+    const std::size_t n = bits <= 54 ? 300 : 7;
+    std::vector<std::uint64_t> keys;
+    std::uint64_t k = 0;
+    for (std::size_t i = 0; i < n; ++i) {
+      k += 1 + (gen() >> (64 - bits));
+      keys.push_back(k);
+    }
+    ExpectRoundTrip(keys);
+  }
+}
+
+TEST_F(DeltaLeafTest, LowerBound) {
+  std::vector<std::uint64_t> keys;
+  for (std::uint64_t i = 0; i < 500; ++i) keys.push_back(100 + i * 10);
+
+  DeltaLeafView view(*Write(MakeInodes(keys)));
+  EXPECT_EQ(view.LowerBound(0), 0);
+  EXPECT_EQ(view.LowerBound(100), 0);
+  EXPECT_EQ(view.LowerBound(101), 1);
+  EXPECT_EQ(view.LowerBound(100 + 128 * 10), 128);
+  EXPECT_EQ(view.LowerBound(100 + 128 * 10 - 1), 128);
+  EXPECT_EQ(view.LowerBound(100 + 499 * 10), 499);
+  EXPECT_EQ(view.LowerBound(100 + 499 * 10 + 1), 500);
+}
+
+TEST_F(DeltaLeafTest, CanDeltaEncode) {
+  auto inodes = MakeInodes({1, 2, 3});
+  EXPECT_TRUE(CanDeltaEncode(inodes));
+
+  inodes[1].flags = LeafFlag::kBucket;
+  EXPECT_FALSE(CanDeltaEncode(inodes));
+
+  inodes = MakeInodes({1, 1});
+  EXPECT_FALSE(CanDeltaEncode(inodes));
+
+  inodes = MakeInodes({1});
+  inodes[0].key.push_back(std::byte{0});
+  EXPECT_FALSE(CanDeltaEncode(inodes));
+}
+
+TEST_F(DeltaLeafTest, NodeRejects) {
+  const auto* p = Write(MakeInodes({1, 2, 3}));
+
+  try {
+    Node n;
+    n.Read(*p);
+    FAIL() << "expected an unsupported page";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code(), Errc::kUnsupportedPage);
+  }
+}
+
+}  // namespace boltdb
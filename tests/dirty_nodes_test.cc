@@ -0,0 +1,239 @@
+#include "dirty_nodes.hh"
+
+#include <gtest/gtest.h>
+
+#include <fcntl.h>
+
+#include <filesystem>
+#include <format>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "test_util.hh"
+
+namespace boltdb {
+
+class DirtyNodesTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+    path_ = std::filesystem::temp_directory_path() /
+            (std::string("boltdb_dirty_nodes_") + info->name());
+    file_ = File(path_, O_RDWR | O_CREAT | O_TRUNC);
+  }
+
+  void TearDown() override {
+    file_.Close();
+    std::filesystem::remove(path_);
+  }
+
+  /// Hands out pages from the end of the file and tracks those not freed.
+  SpillPages Pages() {
+    return {
+        .allocate =
+            [this](std::size_t count) {
+              const PageId id{next_};
+              next_ += count;
+              live_[id] = count;
+              return id;
+            },
+        .free =
+            [this](PageId id, std::size_t count) {
+              ASSERT_EQ(live_.at(id), count);
+              live_.erase(id);
+            },
+    };
+  }
+
+  /// A leaf read from page `id` holding `n` keys with 100-byte values.
+  static Node Leaf(std::uint64_t id, int n) {
+    Node node(true);
+    for (int i = 0; i < n; ++i) {
+      const auto key = std::format("{:04d}-{:06d}", id, i);
+      node.Put(AsBytes(key), AsBytes(key), AsBytes(std::string(100, 'v')),
+               PageId{0}, LeafFlag::kNone);
+    }
+
+    std::vector<std::byte> buf(node.Size());
+    auto* p = reinterpret_cast<Page*>(buf.data());
+    p->id = PageId{id};
+    node.Write(*p);
+    Node read;
+    read.Read(*p);
+
+    return read;
+  }
+
+  std::filesystem::path path_;
+  File file_;
+  std::uint64_t next_ = 2;
+  std::map<PageId, std::size_t> live_;
+};
+
+TEST_F(DirtyNodesTest, StaysWithinBudget) {
+  DirtyNodes nodes(file_, Pages(), SpillOptions{.budget = 16 * 1024});
+
+  std::vector<DirtyNodes::Id> ids;
+  for (std::uint64_t i = 0; i < 50; ++i) ids.push_back(nodes.Add(Leaf(i, 20)));
+  EXPECT_LE(nodes.Bytes(), 16 * 1024);
+  EXPECT_EQ(nodes.Count(), 50);
+  EXPECT_TRUE(nodes.IsSpilled(ids.front()));
+  EXPECT_FALSE(nodes.IsSpilled(ids.back()));
+  EXPECT_GT(nodes.SpilledPages(), 0);
+
+  // Every node reads back whole, with its own page id.
+  for (std::uint64_t i = 0; i < 50; ++i) {
+    const auto& n = nodes.Get(ids[i]);
+    EXPECT_EQ(n.Pgid(), PageId{i});
+    ASSERT_EQ(n.Count(), 20);
+    EXPECT_EQ(AsString(n.GetInodes()[7].Key()),
+              std::format("{:04d}-{:06d}", i, 7));
+    EXPECT_LE(nodes.Bytes(), 16 * 1024);
+  }
+}
+
+TEST_F(DirtyNodesTest, ChangesSurviveSpill) {
+  DirtyNodes nodes(file_, Pages(), SpillOptions{.budget = 8 * 1024});
+
+  const auto id = nodes.Add(Leaf(1, 20));
+  const auto first = std::string(AsString(nodes.Get(id).Key()));
+  nodes.Del(id, AsBytes(first));
+  nodes.Put(id, AsBytes("zzzz"), AsBytes("zzzz"),
+            AsBytes(std::string(3000, 'x')), PageId{0}, LeafFlag::kNone);
+
+  for (std::uint64_t i = 2; i < 10; ++i) nodes.Add(Leaf(i, 10));
+  ASSERT_TRUE(nodes.IsSpilled(id));
+
+  const auto& back = nodes.Get(id);
+  EXPECT_EQ(back.Count(), 20);
+  EXPECT_EQ(AsString(back.Key()), first);
+  EXPECT_TRUE(back.IsUnbalanced());
+  ASSERT_NE(back.Find(AsBytes("zzzz")), nullptr);
+  EXPECT_EQ(back.Find(AsBytes("zzzz"))->Value().size(), 3000);
+  EXPECT_EQ(back.Find(AsBytes(first)), nullptr);
+}
+
+TEST_F(DirtyNodesTest, ReleaseFreesSpillPages) {
+  DirtyNodes nodes(file_, Pages(), SpillOptions{.budget = 4 * 1024});
+
+  std::vector<DirtyNodes::Id> ids;
+  for (std::uint64_t i = 0; i < 10; ++i) ids.push_back(nodes.Add(Leaf(i, 20)));
+  EXPECT_FALSE(live_.empty());
+
+  for (std::uint64_t i = 0; i < 10; ++i) {
+    const auto n = nodes.Release(ids[i]);
+    EXPECT_EQ(n.Pgid(), PageId{i});
+    EXPECT_EQ(n.Count(), 20);
+  }
+  EXPECT_EQ(nodes.Count(), 0);
+  EXPECT_EQ(nodes.Bytes(), 0);
+  EXPECT_TRUE(live_.empty());
+}
+
+TEST_F(DirtyNodesTest, RollbackFreesSpillPages) {
+  {
+    DirtyNodes nodes(file_, Pages(), SpillOptions{.budget = 4 * 1024});
+    for (std::uint64_t i = 0; i < 10; ++i) nodes.Add(Leaf(i, 20));
+    EXPECT_FALSE(live_.empty());
+  }
+  EXPECT_TRUE(live_.empty());
+}
+
+TEST_F(DirtyNodesTest, ThrowingFreeDoesNotEscapeDestructor) {
+  auto pages = Pages();
+  pages.free = [](PageId, std::size_t) {
+    throw std::runtime_error("free failed");
+  };
+
+  {
+    DirtyNodes nodes(file_, pages, SpillOptions{.budget = 4 * 1024});
+    for (std::uint64_t i = 0; i < 4; ++i) nodes.Add(Leaf(i, 20));
+    ASSERT_GT(nodes.SpilledPages(), 0);
+
+    // An explicit rollback reports the failure and still drops every node.
+    EXPECT_THROW(nodes.Rollback(), std::runtime_error);
+    EXPECT_EQ(nodes.Count(), 0);
+
+    nodes.Add(Leaf(5, 20));
+    nodes.Add(Leaf(6, 20));
+    ASSERT_GT(nodes.SpilledPages(), 0);
+  }
+}
+
+TEST_F(DirtyNodesTest, TracksMemory) {
+  MemoryTracker tracker;
+  {
+    DirtyNodes nodes(file_, Pages(), SpillOptions{.budget = 8 * 1024},
+                     &tracker);
+    std::vector<DirtyNodes::Id> ids;
+    for (std::uint64_t i = 0; i < 10; ++i) {
+      ids.push_back(nodes.Add(Leaf(i, 20)));
+    }
+    EXPECT_EQ(tracker.Used(MemoryCategory::kNodes), nodes.Bytes());
+    EXPECT_GT(tracker.Used(MemoryCategory::kKeys), 0);
+    EXPECT_EQ(tracker.Used(MemoryCategory::kPages), 0);
+    EXPECT_GT(tracker.Peak(), tracker.Total());
+
+    // Nodes are charged their heap footprint, not their page size.
+    const auto& last = nodes.Get(ids.back());
+    EXPECT_GT(last.MemoryUsage(), last.Size());
+
+    nodes.Put(ids.back(), AsBytes("zz"), AsBytes("zz"),
+              AsBytes(std::string(500, 'x')), PageId{0}, LeafFlag::kNone);
+    EXPECT_EQ(tracker.Used(MemoryCategory::kNodes), nodes.Bytes());
+    nodes.Del(ids.back(), AsBytes("zz"));
+    EXPECT_EQ(tracker.Used(MemoryCategory::kNodes), nodes.Bytes());
+
+    nodes.Release(ids[3]);
+    EXPECT_EQ(tracker.Used(MemoryCategory::kNodes), nodes.Bytes());
+  }
+  EXPECT_EQ(tracker.Total(), 0);
+}
+
+TEST_F(DirtyNodesTest, FailedSpillFreesPages) {
+  MemoryTracker tracker;
+  DirtyNodes nodes(file_, Pages(), SpillOptions{.budget = 4 * 1024},
+                   &tracker);
+  nodes.Add(Leaf(1, 20));
+
+  file_.Close();
+  EXPECT_THROW(nodes.Add(Leaf(2, 20)), std::system_error);
+  EXPECT_TRUE(live_.empty());
+  EXPECT_EQ(tracker.Used(MemoryCategory::kPages), 0);
+  EXPECT_EQ(tracker.Used(MemoryCategory::kNodes), nodes.Bytes());
+}
+
+TEST_F(DirtyNodesTest, PutFailsOverLimit) {
+  MemoryTracker tracker(8 * 1024);
+  DirtyNodes nodes(file_, Pages(), {}, &tracker);
+  const auto id = nodes.Add(Leaf(1, 20));
+  const auto before = tracker.Total();
+
+  nodes.Put(id, AsBytes("a"), AsBytes("a"), AsBytes("small"), PageId{0},
+            LeafFlag::kNone);
+  EXPECT_EQ(nodes.Get(id).Count(), 21);
+
+  try {
+    nodes.Put(id, AsBytes("b"), AsBytes("b"),
+              AsBytes(std::string(8 * 1024, 'x')), PageId{0},
+              LeafFlag::kNone);
+    FAIL() << "expected the limit to be enforced";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code(), Errc::kMemoryLimitExceeded);
+  }
+  EXPECT_EQ(nodes.Get(id).Count(), 21);
+  EXPECT_EQ(nodes.Get(id).Find(AsBytes("b")), nullptr);
+  EXPECT_GT(tracker.Total(), before);
+  EXPECT_EQ(tracker.Total(), nodes.Bytes());
+
+  // Replacing a value with a smaller one releases the difference.
+  nodes.Put(id, AsBytes("a"), AsBytes("a"), AsBytes("s"), PageId{0},
+            LeafFlag::kNone);
+  EXPECT_EQ(tracker.Total(), nodes.Bytes());
+}
+
+}  // namespace boltdb
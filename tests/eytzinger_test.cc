@@ -0,0 +1,95 @@
+#include "eytzinger.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <format>
+#include <memory>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "test_util.hh"
+
+namespace boltdb {
+
+class EytzingerTest : public ::testing::Test {
+ protected:
+  const Page* Build(std::vector<std::string> keys) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    Node n(false);
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      n.Put(AsBytes(keys[i]), AsBytes(keys[i]), {}, PageId{i + 10},
+            LeafFlag::kNone);
+    }
+
+    const auto size = n.Size() + SearchIndexSize(n.Count());
+    buf = std::make_unique<std::byte[]>(size);
+    auto* p = reinterpret_cast<Page*>(buf.get());
+    WriteIndexedBranch(n, *p);
+    return p;
+  }
+
+  void ExpectSameAsBinary(const Page& p, const std::vector<std::string>& keys) {
+    for (const auto& key : keys) {
+      ASSERT_EQ(SearchIndexedBranch(p, AsBytes(key)),
+                SearchBranch(p.BranchElements(), AsBytes(key),
+                             KeySearch::kBinary))
+          << key;
+    }
+  }
+
+  std::unique_ptr<std::byte[]> buf;
+};
+
+TEST_F(EytzingerTest, PageKeepsBranchElements) {
+  const auto* p = Build({"b", "d", "f"});
+  EXPECT_TRUE(p->IsBranch());
+  EXPECT_TRUE(p->HasSearchIndex());
+  EXPECT_EQ(p->TypeName(), "branch");
+  ASSERT_EQ(p->count, 3);
+  EXPECT_EQ(p->GetBranchElement(1).KeyStr(), "d");
+  EXPECT_EQ(p->GetBranchElement(2).pgid, PageId{12});
+
+  ExpectSameAsBinary(*p, {"", "a", "b", "c", "d", "e", "f", "g"});
+  EXPECT_EQ(SearchBranch(*p, AsBytes("e"), KeySearch::kBinary), 1);
+}
+
+TEST_F(EytzingerTest, RandomKeys) {
+  std::mt19937 gen(11);
+  for (int size : {1, 2, 3, 7, 8, 9, 100, 255}) {
+    std::vector<std::string> keys;
+    for (int i = 0; i < size; ++i) keys.push_back(std::to_string(gen()));
+    const auto* p = Build(keys);
+
+    std::vector<std::string> targets = keys;
+    for (int i = 0; i < 500; ++i) targets.push_back(std::to_string(gen()));
+    targets.push_back("");
+    targets.push_back("\xff");
+    ExpectSameAsBinary(*p, targets);
+  }
+}
+
+TEST_F(EytzingerTest, LongSharedPrefixes) {
+  // All separators share a 12-byte prefix and many tie on the next 8
+  // bytes, exercising the prefix skip and the exact-compare fallback.
+  std::vector<std::string> keys;
+  for (int i = 0; i < 200; ++i) {
+    keys.push_back(std::format("tenant:0042:{:08d}:{}", i / 10, i % 10));
+  }
+  const auto* p = Build(keys);
+
+  std::vector<std::string> targets = keys;
+  targets.push_back("tenant:0042");
+  targets.push_back("tenant:0041:zzz");
+  targets.push_back("tenant:0043");
+  targets.push_back("tenant:0042:00000005");
+  targets.push_back("tenant:0042:00000005:55");
+  targets.push_back("tenant:0042:99999999");
+  ExpectSameAsBinary(*p, targets);
+}
+
+}  // namespace boltdb
@@ -0,0 +1,116 @@
+#include "hash_bucket.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <format>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "test_util.hh"
+
+namespace boltdb {
+
+TEST(HashDirectoryTest, SplitDoublesAtGlobalDepth) {
+  HashDirectory dir(PageId{10});
+  EXPECT_EQ(dir.GlobalDepth(), 0);
+  EXPECT_EQ(dir.SlotCount(), 1);
+
+  dir.Split(0, PageId{11});
+  EXPECT_EQ(dir.GlobalDepth(), 1);
+  EXPECT_EQ(dir.SlotPage(0), PageId{10});
+  EXPECT_EQ(dir.SlotPage(1), PageId{11});
+
+  // Splitting slot 0 doubles again; slot 1's bucket is now shared by
+  // slots 1 and 3 at local depth 1.
+  dir.Split(0, PageId{12});
+  EXPECT_EQ(dir.GlobalDepth(), 2);
+  EXPECT_EQ(dir.SlotPage(0), PageId{10});
+  EXPECT_EQ(dir.SlotPage(1), PageId{11});
+  EXPECT_EQ(dir.SlotPage(2), PageId{12});
+  EXPECT_EQ(dir.SlotPage(3), PageId{11});
+  EXPECT_EQ(dir.LocalDepth(1), 1);
+  EXPECT_EQ(dir.LocalDepth(2), 2);
+
+  // Splitting a bucket below the global depth does not double.
+  dir.Split(3, PageId{13});
+  EXPECT_EQ(dir.GlobalDepth(), 2);
+  EXPECT_EQ(dir.SlotPage(1), PageId{11});
+  EXPECT_EQ(dir.SlotPage(3), PageId{13});
+
+  dir.Relocate(PageId{11}, PageId{20});
+  EXPECT_EQ(dir.SlotPage(1), PageId{20});
+  EXPECT_EQ(dir.BucketPages(),
+            (PageIds{PageId{10}, PageId{12}, PageId{13}, PageId{20}}));
+}
+
+TEST(HashDirectoryTest, WriteRead) {
+  HashDirectory dir(PageId{1});
+  dir.Split(0, PageId{2});
+  dir.Split(1, PageId{3});
+
+  auto buf = std::make_unique<std::byte[]>(dir.Size());
+  auto* p = reinterpret_cast<Page*>(buf.get());
+  dir.Write(*p);
+  EXPECT_TRUE(p->IsHashDirectory());
+  EXPECT_EQ(p->TypeName(), "hash-directory");
+
+  HashDirectory got;
+  got.Read(*p);
+  ASSERT_EQ(got.GlobalDepth(), dir.GlobalDepth());
+  for (std::size_t i = 0; i < dir.SlotCount(); ++i) {
+    EXPECT_EQ(got.SlotPage(i), dir.SlotPage(i));
+    EXPECT_EQ(got.LocalDepth(i), dir.LocalDepth(i));
+  }
+}
+
+TEST(HashBucketTest, PutGet) {
+  constexpr std::size_t kPageSize = 512;
+  constexpr int kKeys = 2000;
+
+  std::uint64_t next_pgid = 1;
+  HashDirectory dir(PageId{next_pgid});
+  std::map<PageId, Node> nodes;
+  nodes.emplace(PageId{next_pgid++}, Node(true));
+
+  for (int i = 0; i < kKeys; ++i) {
+    const auto key = std::format("session:{}", i);
+    const auto value = std::format("v{}", i);
+    const auto slot = dir.SlotFor(HashBucketKey(AsBytes(key)));
+    auto& node = nodes.at(dir.SlotPage(slot));
+    node.Put(AsBytes(key), AsBytes(key), AsBytes(value), PageId{0},
+             LeafFlag::kNone);
+
+    if (node.Size() > kPageSize && dir.CanSplit(slot)) {
+      const auto depth = dir.LocalDepth(slot);
+      const PageId sibling{next_pgid++};
+      nodes.emplace(sibling, SplitHashBucket(node, depth));
+      dir.Split(slot, sibling);
+    }
+  }
+  EXPECT_GT(dir.GlobalDepth(), 3);
+
+  std::map<PageId, std::unique_ptr<std::byte[]>> pages;
+  for (const auto& [pgid, node] : nodes) {
+    auto buf = std::make_unique<std::byte[]>(node.Size());
+    auto* p = reinterpret_cast<Page*>(buf.get());
+    p->id = pgid;
+    WriteHashBucket(node, *p);
+    pages.emplace(pgid, std::move(buf));
+  }
+  const PageResolver resolve = [&](PageId id) {
+    return reinterpret_cast<const Page*>(pages.at(id).get());
+  };
+
+  for (int i = 0; i < kKeys; ++i) {
+    const auto key = std::format("session:{}", i);
+    const auto got = HashBucketGet(dir, resolve, AsBytes(key));
+    ASSERT_TRUE(got.has_value()) << key;
+    EXPECT_EQ(AsString(*got), std::format("v{}", i));
+  }
+  EXPECT_FALSE(HashBucketGet(dir, resolve, AsBytes("missing")).has_value());
+}
+
+}  // namespace boltdb
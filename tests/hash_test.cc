@@ -0,0 +1,39 @@
+#include "hash.hh"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <string_view>
+
+#include "test_util.hh"
+
+namespace boltdb {
+
+TEST(HashTest, XXH64KnownValues) {
+  EXPECT_EQ(HashBytes(AsBytes("")), 0xEF46DB3751D8E999ULL);
+  EXPECT_EQ(HashBytes(AsBytes("a")), 0xD24EC4F1A98C6E5BULL);
+  EXPECT_EQ(HashBytes(AsBytes("abc")), 0x44BC2CF5AD770999ULL);
+}
+
+TEST(HashTest, AllInputLengths) {
+  // Exercise the stripe, 8-byte, 4-byte and tail paths; every prefix must
+  // hash differently and deterministically.
+  std::string s;
+  for (int i = 0; i < 100; ++i) {
+    s.push_back(static_cast<char>('a' + i % 26));
+    const auto h = HashBytes(AsBytes(s));
+    EXPECT_EQ(h, HashBytes(AsBytes(s)));
+    EXPECT_NE(h, HashBytes(AsBytes(s.substr(0, s.size() - 1))));
+    EXPECT_NE(h, HashBytes(AsBytes(s), 1));
+  }
+}
+
+TEST(HashTest, HashBytes128) {
+  const auto h = HashBytes128(AsBytes("hello"));
+  EXPECT_EQ(h, HashBytes128(AsBytes("hello")));
+  EXPECT_NE(h, HashBytes128(AsBytes("hellp")));
+  EXPECT_EQ(h.hi, HashBytes(AsBytes("hello")));
+  EXPECT_NE(h.hi, h.lo);
+}
+
+}  // namespace boltdb
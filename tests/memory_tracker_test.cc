@@ -0,0 +1,72 @@
+#include "memory_tracker.hh"
+
+#include <gtest/gtest.h>
+
+#include <system_error>
+
+namespace boltdb {
+
+TEST(MemoryTrackerTest, ChargeAndRelease) {
+  MemoryTracker tracker;
+  tracker.Charge(MemoryCategory::kNodes, 100);
+  tracker.Charge(MemoryCategory::kKeys, 20);
+  tracker.Release(MemoryCategory::kNodes, 40);
+
+  EXPECT_EQ(tracker.Used(MemoryCategory::kNodes), 60);
+  EXPECT_EQ(tracker.Used(MemoryCategory::kKeys), 20);
+  EXPECT_EQ(tracker.Used(MemoryCategory::kPages), 0);
+  EXPECT_EQ(tracker.Total(), 80);
+  EXPECT_EQ(tracker.Peak(), 120);
+}
+
+TEST(MemoryTrackerTest, LimitRejectsCharge) {
+  MemoryTracker tracker(100);
+  tracker.Charge(MemoryCategory::kNodes, 90);
+
+  try {
+    tracker.Charge(MemoryCategory::kNodes, 20);
+    FAIL() << "expected the limit to be enforced";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code(), Errc::kMemoryLimitExceeded);
+  }
+  EXPECT_EQ(tracker.Total(), 90);
+  EXPECT_EQ(tracker.Used(MemoryCategory::kNodes), 90);
+
+  tracker.Charge(MemoryCategory::kNodes, 10);
+  EXPECT_EQ(tracker.Total(), 100);
+}
+
+TEST(MemoryTrackerTest, AccountIgnoresLimit) {
+  MemoryTracker tracker(100);
+  tracker.Account(MemoryCategory::kNodes, 150);
+  EXPECT_EQ(tracker.Total(), 150);
+  EXPECT_THROW(tracker.Charge(MemoryCategory::kNodes, 1), std::system_error);
+
+  tracker.SetLimit(MemoryTracker::kUnlimited);
+  tracker.Charge(MemoryCategory::kNodes, 1);
+  EXPECT_EQ(tracker.Total(), 151);
+}
+
+TEST(MemoryTrackerTest, ParentLimit) {
+  MemoryTracker worker(100);
+  {
+    MemoryTracker tx(80, &worker);
+    MemoryTracker other(80, &worker);
+    tx.Charge(MemoryCategory::kNodes, 60);
+    EXPECT_EQ(worker.Total(), 60);
+
+    // Within its own limit but not the worker's.
+    EXPECT_THROW(other.Charge(MemoryCategory::kNodes, 50), std::system_error);
+    EXPECT_EQ(other.Total(), 0);
+    EXPECT_EQ(worker.Total(), 60);
+
+    other.Charge(MemoryCategory::kKeys, 40);
+    EXPECT_EQ(worker.Used(MemoryCategory::kKeys), 40);
+  }
+
+  // Finished transactions return what they held.
+  EXPECT_EQ(worker.Total(), 0);
+  EXPECT_EQ(worker.Peak(), 100);
+}
+
+}  // namespace boltdb
@@ -0,0 +1,124 @@
+#include "merge_cursor.hh"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "node.hh"
+#include "test_util.hh"
+
+namespace boltdb {
+
+/// Single-leaf buckets, one per source.
+class MergeCursorTest : public ::testing::Test {
+ protected:
+  void AddBucket(
+      const std::vector<std::pair<std::string, std::string>>& items) {
+    Node n(true);
+    for (const auto& [k, v] : items) {
+      n.Put(AsBytes(k), AsBytes(k), AsBytes(v), PageId{0}, LeafFlag::kNone);
+    }
+
+    const PageId id{pages.size() + 1};
+    auto buf = std::make_unique<std::byte[]>(n.Size());
+    n.Write(*reinterpret_cast<Page*>(buf.get()));
+    pages.emplace(id, std::move(buf));
+    roots.push_back(id);
+  }
+
+  std::vector<Cursor> Cursors() {
+    std::vector<Cursor> cursors;
+    for (auto root : roots) {
+      cursors.emplace_back(
+          [this](PageId id) {
+            return reinterpret_cast<const Page*>(pages.at(id).get());
+          },
+          root);
+    }
+    return cursors;
+  }
+
+  static std::vector<std::string> Drain(MergeCursor& c,
+                                        std::optional<KeyValue> kv) {
+    std::vector<std::string> out;
+    for (; kv; kv = c.Next()) {
+      out.push_back(std::string(AsString(kv->key)) + "=" +
+                    std::string(AsString(kv->value)));
+    }
+    return out;
+  }
+
+  std::map<PageId, std::unique_ptr<std::byte[]>> pages;
+  std::vector<PageId> roots;
+};
+
+TEST_F(MergeCursorTest, MergesInKeyOrder) {
+  AddBucket({{"a", "0"}, {"d", "0"}, {"g", "0"}});
+  AddBucket({{"b", "1"}, {"e", "1"}});
+  AddBucket({});
+  AddBucket({{"c", "3"}, {"f", "3"}, {"h", "3"}, {"i", "3"}});
+
+  MergeCursor c(Cursors());
+  EXPECT_EQ(Drain(c, c.First()),
+            (std::vector<std::string>{"a=0", "b=1", "c=3", "d=0", "e=1",
+                                      "f=3", "g=0", "h=3", "i=3"}));
+  EXPECT_FALSE(c.Next().has_value());
+}
+
+TEST_F(MergeCursorTest, ConflictResolution) {
+  AddBucket({{"a", "old"}, {"k", "old"}});
+  AddBucket({{"k", "mid"}});
+  AddBucket({{"k", "new"}, {"z", "new"}});
+
+  MergeCursor first(Cursors(), PreferFirstSource);
+  EXPECT_EQ(Drain(first, first.First()),
+            (std::vector<std::string>{"a=old", "k=old", "z=new"}));
+
+  MergeCursor last(Cursors(), PreferLastSource);
+  auto kv = last.Seek(AsBytes("b"));
+  ASSERT_TRUE(kv.has_value());
+  EXPECT_EQ(AsString(kv->value), "new");
+  EXPECT_EQ(last.Source(), 2);
+
+  MergeCursor all(Cursors(), nullptr);
+  EXPECT_EQ(Drain(all, all.First()),
+            (std::vector<std::string>{"a=old", "k=old", "k=mid", "k=new",
+                                      "z=new"}));
+
+  // A custom resolver sees every tied entry, ordered by source.
+  MergeCursor custom(Cursors(), [](std::span<const MergeEntry> tied) {
+    EXPECT_EQ(tied.size(), 3);
+    return std::size_t{1};
+  });
+  EXPECT_EQ(Drain(custom, custom.Seek(AsBytes("k"))),
+            (std::vector<std::string>{"k=mid", "z=new"}));
+}
+
+TEST_F(MergeCursorTest, ManySources) {
+  std::vector<std::string> want;
+  for (int s = 0; s < 13; ++s) {
+    std::vector<std::pair<std::string, std::string>> items;
+    for (int i = s; i < 200; i += 13) {
+      const auto key = std::to_string(1000 + i);
+      items.emplace_back(key, "v");
+    }
+    AddBucket(items);
+  }
+  for (int i = 0; i < 200; ++i) want.push_back(std::to_string(1000 + i) + "=v");
+
+  MergeCursor c(Cursors());
+  EXPECT_EQ(Drain(c, c.First()), want);
+}
+
+TEST_F(MergeCursorTest, NoSources) {
+  MergeCursor c({});
+  EXPECT_FALSE(c.First().has_value());
+  EXPECT_FALSE(c.Next().has_value());
+}
+
+}  // namespace boltdb
@@ -0,0 +1,115 @@
+#include "merge_operator.hh"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <cstdint>
+#include <format>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "test_util.hh"
+
+namespace boltdb {
+
+std::array<std::byte, 8> U64(std::uint64_t v) {
+  std::array<std::byte, 8> b{};
+  StoreBigEndian64(b.data(), v);
+  return b;
+}
+
+TEST(MergeOperatorTest, Builtins) {
+  MergeOperators ops;
+  const auto* add = ops.Find("add-u64");
+  const auto* max = ops.Find("max");
+  const auto* append = ops.Find("append");
+  ASSERT_NE(add, nullptr);
+  ASSERT_NE(max, nullptr);
+  ASSERT_NE(append, nullptr);
+  EXPECT_EQ(ops.Find("missing"), nullptr);
+
+  EXPECT_EQ(LoadBigEndian64((*add)(U64(40), U64(2)).data()), 42);
+  EXPECT_EQ(AsString((*max)(AsBytes("abc"), AsBytes("abd"))), "abd");
+  EXPECT_EQ(AsString((*max)(AsBytes("b"), AsBytes("abc"))), "b");
+  EXPECT_EQ(AsString((*append)(AsBytes("ab"), AsBytes("cd"))), "abcd");
+  EXPECT_THROW((*add)(AsBytes("x"), U64(1)), std::system_error);
+
+  // Counters share max's byte order, so the larger count wins.
+  EXPECT_EQ(LoadBigEndian64((*max)(U64(256), U64(255)).data()), 256);
+}
+
+TEST(MergeOperatorTest, ApplyBatch) {
+  Node n(true);
+  for (int i = 0; i < 10; i += 2) {
+    const auto key = std::format("k{}", i);
+    const auto one = U64(100);
+    n.Put(AsBytes(key), AsBytes(key), one, PageId{0}, LeafFlag::kNone);
+  }
+
+  // Sorted batch hitting existing keys (k0, k4) and new ones (k1, k9),
+  // several times for some.
+  const std::vector<std::string> keys = {"k0", "k0", "k1", "k4",
+                                         "k4", "k4", "k9"};
+  const auto one = U64(1);
+  std::vector<MergeOperand> batch;
+  for (const auto& key : keys) batch.push_back({AsBytes(key), one});
+
+  ApplyMerges(n, batch, MergeAddU64);
+
+  const auto& inodes = n.GetInodes();
+  ASSERT_EQ(inodes.size(), 7);
+  const std::vector<std::pair<std::string, std::uint64_t>> want = {
+      {"k0", 102}, {"k1", 1}, {"k2", 100}, {"k4", 103},
+      {"k6", 100}, {"k8", 100}, {"k9", 1}};
+  for (std::size_t i = 0; i < want.size(); ++i) {
+    EXPECT_EQ(AsString(inodes[i].Key()), want[i].first);
+    EXPECT_EQ(LoadBigEndian64(inodes[i].Value().data()), want[i].second);
+  }
+}
+
+TEST(MergeOperatorTest, FailedBatchLeavesNodeUnchanged) {
+  Node n(true);
+  for (const auto* key : {"a", "c", "e"}) {
+    n.Put(AsBytes(key), AsBytes(key), U64(1), PageId{0}, LeafFlag::kNone);
+  }
+  n.Put(AsBytes("z"), AsBytes("z"), AsBytes("bad"), PageId{0},
+        LeafFlag::kNone);
+
+  // Updates, an insert and finally a key whose value is not a counter.
+  const auto one = U64(1);
+  const std::vector<MergeOperand> batch = {{AsBytes("a"), one},
+                                           {AsBytes("b"), one},
+                                           {AsBytes("e"), one},
+                                           {AsBytes("z"), one}};
+  try {
+    ApplyMerges(n, batch, MergeAddU64);
+    FAIL() << "expected the last key to fail";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code(), Errc::kIncompatibleValue);
+  }
+
+  const auto& inodes = n.GetInodes();
+  ASSERT_EQ(inodes.size(), 4);
+  EXPECT_EQ(LoadBigEndian64(inodes[0].Value().data()), 1);
+  EXPECT_EQ(AsString(inodes[1].Key()), "c");
+  EXPECT_EQ(LoadBigEndian64(inodes[2].Value().data()), 1);
+  EXPECT_EQ(AsString(inodes[3].Value()), "bad");
+  EXPECT_FALSE(n.IsUnbalanced());
+}
+
+TEST(MergeOperatorTest, AppendFoldsInOrder) {
+  Node n(true);
+  n.Put(AsBytes("log"), AsBytes("log"), AsBytes("a"), PageId{0},
+        LeafFlag::kNone);
+
+  const std::vector<MergeOperand> batch = {{AsBytes("log"), AsBytes("b")},
+                                           {AsBytes("log"), AsBytes("c")}};
+  ApplyMerges(n, batch, MergeAppend);
+
+  ASSERT_EQ(n.Count(), 1);
+  EXPECT_EQ(AsString(n.GetInodes()[0].Value()), "abc");
+}
+
+}  // namespace boltdb
@@ -0,0 +1,323 @@
+#include "node.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <format>
+#include <memory>
+#include <optional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "test_util.hh"
+
+namespace boltdb {
+
+void PutString(Node& n, std::string_view key, std::string_view value) {
+  n.Put(AsBytes(key), AsBytes(key), AsBytes(value), PageId{0},
+        LeafFlag::kNone);
+}
+
+std::string Key(int i) { return std::format("{:08d}", i); }
+
+TEST(NodeTest, Put) {
+  Node n(true);
+  PutString(n, "baz", "2");
+  PutString(n, "foo", "0");
+  PutString(n, "bar", "1");
+  PutString(n, "foo", "3");
+
+  const auto& inodes = n.GetInodes();
+  ASSERT_EQ(inodes.size(), 3);
+  EXPECT_EQ(AsString(inodes[0].Key()), "bar");
+  EXPECT_EQ(AsString(inodes[0].Value()), "1");
+  EXPECT_EQ(AsString(inodes[1].Key()), "baz");
+  EXPECT_EQ(AsString(inodes[1].Value()), "2");
+  EXPECT_EQ(AsString(inodes[2].Key()), "foo");
+  EXPECT_EQ(AsString(inodes[2].Value()), "3");
+
+  n.Del(AsBytes("baz"));
+  n.Del(AsBytes("missing"));
+  ASSERT_EQ(n.Count(), 2);
+  EXPECT_EQ(AsString(n.GetInodes()[1].Key()), "foo");
+}
+
+TEST(NodeTest, PutReserve) {
+  Node n(true);
+  PutString(n, "a", "old");
+
+  auto buf = n.PutReserve(AsBytes("a"), 5);
+  ASSERT_EQ(buf.size(), 5);
+  EXPECT_EQ(buf[0], std::byte{0});
+  std::memcpy(buf.data(), "hello", 5);
+
+  // The reserved buffer is the node's own value storage and moves with
+  // its inode.
+  PutString(n, "0", "2");
+  EXPECT_EQ(buf.data(), n.GetInodes()[1].Value().data());
+  EXPECT_EQ(AsString(n.GetInodes()[1].Value()), "hello");
+  ASSERT_EQ(n.Count(), 2);
+}
+
+TEST(NodeTest, PutReserveRejects) {
+  Node n(true);
+  n.Put(AsBytes("sub"), AsBytes("sub"), AsBytes("header"), PageId{0},
+        LeafFlag::kBucket);
+
+  const auto expect_error = [&](std::span<const std::byte> key,
+                                std::size_t size, Errc want) {
+    try {
+      n.PutReserve(key, size);
+      FAIL() << "expected the reservation to be rejected";
+    } catch (const std::system_error& e) {
+      EXPECT_EQ(e.code(), want);
+    }
+  };
+  expect_error({}, 1, Errc::kKeyRequired);
+  const std::vector<std::byte> long_key(kMaxKeySize + 1, std::byte{'k'});
+  expect_error(long_key, 1, Errc::kKeyTooLarge);
+  expect_error(AsBytes("v"), kMaxValueSize + 1, Errc::kValueTooLarge);
+  expect_error(AsBytes("sub"), 4, Errc::kIncompatibleValue);
+
+  // The sub-bucket entry is left as it was.
+  ASSERT_EQ(n.Count(), 1);
+  EXPECT_EQ(n.GetInodes()[0].flags, LeafFlag::kBucket);
+  EXPECT_EQ(AsString(n.GetInodes()[0].Value()), "header");
+}
+
+std::vector<std::byte> ToVector(std::string_view s) {
+  const auto b = AsBytes(s);
+  return {b.begin(), b.end()};
+}
+
+TEST(NodeTest, Update) {
+  Node n(true);
+  PutString(n, "a", "1");
+  PutString(n, "c", "3");
+
+  // Insert an absent key at its position.
+  n.Update(AsBytes("b"), [](auto old) {
+    EXPECT_FALSE(old.has_value());
+    return std::optional(ToVector("2"));
+  });
+
+  // Modify in place, seeing the current value.
+  n.Update(AsBytes("c"), [](auto old) {
+    EXPECT_EQ(AsString(*old), "3");
+    return std::optional(ToVector("33"));
+  });
+
+  // Delete, and leave an absent key absent.
+  n.Update(AsBytes("a"), [](auto) {
+    return std::optional<std::vector<std::byte>>();
+  });
+  n.Update(AsBytes("z"), [](auto) {
+    return std::optional<std::vector<std::byte>>();
+  });
+
+  const auto& inodes = n.GetInodes();
+  ASSERT_EQ(inodes.size(), 2);
+  EXPECT_EQ(AsString(inodes[0].Key()), "b");
+  EXPECT_EQ(AsString(inodes[0].Value()), "2");
+  EXPECT_EQ(AsString(inodes[1].Key()), "c");
+  EXPECT_EQ(AsString(inodes[1].Value()), "33");
+  EXPECT_TRUE(n.IsUnbalanced());
+
+  n.Put(AsBytes("sub"), AsBytes("sub"), {}, PageId{0}, LeafFlag::kBucket);
+  EXPECT_THROW(n.Update(AsBytes("sub"),
+                        [](auto) { return std::optional(ToVector("x")); }),
+               std::system_error);
+}
+
+TEST(NodeTest, UpdateSorted) {
+  Node n(true);
+  PutString(n, "b", "1");
+  PutString(n, "d", "2");
+
+  const std::vector<std::span<const std::byte>> keys = {
+      AsBytes("a"), AsBytes("b"), AsBytes("c"), AsBytes("d"), AsBytes("e")};
+  n.UpdateSorted(keys, [](std::size_t i, auto old) {
+    // Delete "b", keep "d", insert "a", "c" and "e".
+    if (i == 1) return std::optional<std::vector<std::byte>>();
+    if (old) return std::optional(std::vector(old->begin(), old->end()));
+    return std::optional(ToVector(std::string(1, static_cast<char>('a' + i))));
+  });
+
+  const auto& inodes = n.GetInodes();
+  ASSERT_EQ(inodes.size(), 4);
+  EXPECT_EQ(AsString(inodes[0].Key()), "a");
+  EXPECT_EQ(AsString(inodes[1].Key()), "c");
+  EXPECT_EQ(AsString(inodes[1].Value()), "c");
+  EXPECT_EQ(AsString(inodes[2].Key()), "d");
+  EXPECT_EQ(AsString(inodes[2].Value()), "2");
+  EXPECT_EQ(AsString(inodes[3].Key()), "e");
+  EXPECT_TRUE(n.IsUnbalanced());
+}
+
+TEST(NodeTest, WriteRead) {
+  Node n(true);
+  PutString(n, "susy", "que");
+  PutString(n, "ricki", "lake");
+  PutString(n, "john", "johnson");
+
+  auto buf = std::make_unique<std::byte[]>(4096);
+  std::memset(buf.get(), 0, 4096);
+  auto* p = reinterpret_cast<Page*>(buf.get());
+  p->id = PageId{7};
+  n.Write(*p);
+
+  Node n2;
+  n2.Read(*p);
+  EXPECT_TRUE(n2.IsLeaf());
+  EXPECT_EQ(n2.Pgid(), PageId{7});
+  EXPECT_EQ(AsString(n2.Key()), "john");
+
+  const auto& inodes = n2.GetInodes();
+  ASSERT_EQ(inodes.size(), 3);
+  EXPECT_EQ(AsString(inodes[0].Key()), "john");
+  EXPECT_EQ(AsString(inodes[0].Value()), "johnson");
+  EXPECT_EQ(AsString(inodes[2].Key()), "susy");
+  EXPECT_EQ(AsString(inodes[2].Value()), "que");
+}
+
+TEST(NodeTest, SplitDefaultFillPercent) {
+  Node n(true);
+  for (int i = 1; i <= 5; ++i) PutString(n, Key(i), "0123456701234567");
+
+  // Split between 2 & 3 with a 100 byte page and the default fill percent.
+  auto siblings = n.Split(100, kDefaultFillPercent);
+  ASSERT_EQ(siblings.size(), 1);
+  EXPECT_EQ(n.Count(), 2);
+  EXPECT_EQ(siblings[0].Count(), 3);
+}
+
+TEST(NodeTest, SplitLeavesNoTinyPage) {
+  Node n(true);
+  for (int i = 1; n.SizeLessThan(1100); ++i) {
+    PutString(n, Key(i), "0123456701234567");
+  }
+  ASSERT_GT(n.Size(), 1024);
+
+  // Once the first half is split off, the rest fits a page and is kept
+  // whole rather than split again at the fill percent.
+  auto siblings = n.Split(1024, kDefaultFillPercent);
+  ASSERT_EQ(siblings.size(), 1);
+  EXPECT_LE(n.Size(), 1024);
+  EXPECT_LE(siblings[0].Size(), 1024);
+}
+
+TEST(NodeTest, SplitMinKeys) {
+  Node n(true);
+  PutString(n, Key(1), "0123456701234567");
+  PutString(n, Key(2), "0123456701234567");
+
+  EXPECT_TRUE(n.Split(20, kDefaultFillPercent).empty());
+}
+
+TEST(NodeTest, SplitSinglePage) {
+  Node n(true);
+  for (int i = 1; i <= 5; ++i) PutString(n, Key(i), "0123456701234567");
+
+  EXPECT_TRUE(n.Split(4096, kDefaultFillPercent).empty());
+}
+
+TEST(NodeTest, UnderfilledAndMerge) {
+  Node left(true);
+  Node right(true);
+  PutString(left, Key(1), "0123456701234567");
+  PutString(left, Key(2), "0123456701234567");
+  PutString(right, Key(3), "0123456701234567");
+  PutString(right, Key(4), "0123456701234567");
+  EXPECT_FALSE(left.IsUnbalanced());
+  EXPECT_FALSE(left.IsUnderfilled(256));
+  EXPECT_TRUE(left.IsUnderfilled(4096));
+
+  right.Del(AsBytes(Key(4)));
+  EXPECT_TRUE(right.IsUnbalanced());
+  EXPECT_TRUE(right.IsUnderfilled(256));
+
+  left.MergeFrom(right);
+  EXPECT_EQ(left.Count(), 3);
+  EXPECT_EQ(right.Count(), 0);
+  EXPECT_EQ(AsString(left.GetInodes().back().Key()), Key(3));
+}
+
+TEST(InsertPatternTrackerTest, Classify) {
+  InsertPatternTracker tracker;
+  EXPECT_EQ(tracker.Pattern(), InsertPattern::kUnknown);
+
+  for (int i = 1; i <= 100; ++i) tracker.Record(i, i);
+  EXPECT_EQ(tracker.Pattern(), InsertPattern::kAscending);
+
+  // The window halves old samples, so a new pattern takes over.
+  for (int i = 1; i <= 100; ++i) tracker.Record(0, i);
+  EXPECT_EQ(tracker.Pattern(), InsertPattern::kDescending);
+
+  for (int i = 1; i <= 100; ++i) tracker.Record(i / 2, i);
+  EXPECT_EQ(tracker.Pattern(), InsertPattern::kRandom);
+}
+
+TEST(NodeTest, SplitAscendingPacksLeftPages) {
+  InsertPatternTracker tracker;
+  Node n(true);
+  n.SetInsertPatternTracker(&tracker);
+  for (int i = 0; i < 200; ++i) PutString(n, Key(i), "0123456701234567");
+  ASSERT_EQ(tracker.Pattern(), InsertPattern::kAscending);
+
+  constexpr std::size_t kPageSize = 1024;
+  auto siblings = n.Split(kPageSize, kDefaultFillPercent);
+  ASSERT_FALSE(siblings.empty());
+
+  // Every page but the last is filled to the page size.
+  EXPECT_GT(n.Size(), kPageSize * 9 / 10);
+  for (std::size_t i = 0; i + 1 < siblings.size(); ++i) {
+    EXPECT_GT(siblings[i].Size(), kPageSize * 9 / 10);
+    EXPECT_LE(siblings[i].Size(), kPageSize);
+  }
+}
+
+TEST(NodeTest, SplitDescendingPacksRightPages) {
+  InsertPatternTracker tracker;
+  Node n(true);
+  n.SetInsertPatternTracker(&tracker);
+  for (int i = 200; i > 0; --i) PutString(n, Key(i), "0123456701234567");
+  ASSERT_EQ(tracker.Pattern(), InsertPattern::kDescending);
+
+  constexpr std::size_t kPageSize = 1024;
+  auto siblings = n.Split(kPageSize, kDefaultFillPercent);
+  ASSERT_FALSE(siblings.empty());
+
+  // Every page after the first is filled to the page size, and keys stay
+  // ordered across pieces.
+  EXPECT_LE(n.Size(), kPageSize);
+  for (const auto& sibling : siblings) {
+    EXPECT_GT(sibling.Size(), kPageSize * 9 / 10);
+    EXPECT_LE(sibling.Size(), kPageSize);
+  }
+  EXPECT_EQ(AsString(n.GetInodes().front().Key()), Key(1));
+  EXPECT_EQ(AsString(siblings.back().GetInodes().back().Key()), Key(200));
+}
+
+TEST(NodeTest, SplitRandomHalfFills) {
+  InsertPatternTracker tracker;
+  Node n(true);
+  n.SetInsertPatternTracker(&tracker);
+
+  std::vector<int> keys(200);
+  for (int i = 0; i < 200; ++i) keys[i] = i;
+  std::mt19937 gen(42);
+  std::shuffle(keys.begin(), keys.end(), gen);
+  for (int k : keys) PutString(n, Key(k), "0123456701234567");
+  ASSERT_EQ(tracker.Pattern(), InsertPattern::kRandom);
+
+  constexpr std::size_t kPageSize = 1024;
+  auto siblings = n.Split(kPageSize, kMaxFillPercent);
+  ASSERT_FALSE(siblings.empty());
+  EXPECT_LE(n.Size(), kPageSize / 2);
+  EXPECT_GT(n.Size(), kPageSize / 2 - 64);
+}
+
+}  // namespace boltdb
@@ -0,0 +1,149 @@
+#include "page_cipher.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "node.hh"
+#include "test_util.hh"
+
+namespace boltdb {
+
+std::vector<std::byte> Key(std::size_t n, int seed) {
+  std::vector<std::byte> key(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    key[i] = static_cast<std::byte>(seed + static_cast<int>(i));
+  }
+  return key;
+}
+
+/// A leaf page of `size` bytes holding a few keys, with room for the
+/// cipher trailer.
+std::vector<std::byte> LeafRun(PageId id, std::size_t size) {
+  Node n(true);
+  for (const auto* key : {"alpha", "bravo", "charlie"}) {
+    n.Put(AsBytes(key), AsBytes(key), AsBytes("secret"), PageId{0},
+          LeafFlag::kNone);
+  }
+  EXPECT_LE(n.Size(), size - PageCipher::kOverhead);
+
+  std::vector<std::byte> run(size);
+  auto* p = reinterpret_cast<Page*>(run.data());
+  n.Write(*p);
+  p->id = id;
+  return run;
+}
+
+TEST(PageCipherTest, RoundTrip) {
+  const PageCipher cipher(Key(32, 1));
+  const auto plain = LeafRun(PageId{42}, 4096);
+
+  auto run = plain;
+  cipher.Encrypt(run, 7);
+  EXPECT_EQ(PageCipher::WrittenBy(run), 7);
+
+  // Header in the clear, body encrypted.
+  EXPECT_EQ(std::memcmp(run.data(), plain.data(), Page::kHeaderSize), 0);
+  EXPECT_NE(std::memcmp(run.data() + Page::kHeaderSize,
+                        plain.data() + Page::kHeaderSize, 64),
+            0);
+
+  // Decrypt into a separate buffer, as from a read-only mapping.
+  std::vector<std::byte> out(run.size());
+  cipher.Decrypt(run, out);
+  const auto* p = reinterpret_cast<const Page*>(out.data());
+  ASSERT_EQ(p->count, 3);
+  EXPECT_EQ(AsString(p->GetLeafElement(1).Key()), "bravo");
+  EXPECT_EQ(AsString(p->GetLeafElement(1).Value()), "secret");
+  EXPECT_EQ(std::memcmp(out.data(), plain.data(),
+                        plain.size() - PageCipher::kOverhead),
+            0);
+
+  // And in place.
+  cipher.Decrypt(run, run);
+  EXPECT_EQ(std::memcmp(run.data(), plain.data(),
+                        plain.size() - PageCipher::kOverhead),
+            0);
+}
+
+TEST(PageCipherTest, FreshIvPerWrite) {
+  const PageCipher cipher(Key(32, 3));
+  auto a = LeafRun(PageId{5}, 1024);
+  auto b = a;
+  auto c = LeafRun(PageId{6}, 1024);
+
+  // The same page rewritten by another txid, or another page with the same
+  // contents, never repeats the keystream.
+  cipher.Encrypt(a, 1);
+  cipher.Encrypt(b, 2);
+  cipher.Encrypt(c, 1);
+  const auto body = [](const std::vector<std::byte>& run) {
+    return std::vector(run.begin() + Page::kHeaderSize,
+                       run.end() - PageCipher::kOverhead);
+  };
+  EXPECT_NE(body(a), body(b));
+  EXPECT_NE(body(a), body(c));
+}
+
+TEST(PageCipherTest, RolledBackTxidGetsFreshIv) {
+  const PageCipher cipher(Key(32, 4));
+
+  // A rolled-back writer's txid is reused by the next one, which writes
+  // the same page with other contents.
+  auto first = LeafRun(PageId{8}, 1024);
+  cipher.Encrypt(first, 5);
+  Node n(true);
+  n.Put(AsBytes("other"), AsBytes("other"), AsBytes("contents"), PageId{0},
+        LeafFlag::kNone);
+  auto second = std::vector<std::byte>(1024);
+  n.Write(*reinterpret_cast<Page*>(second.data()));
+  reinterpret_cast<Page*>(second.data())->id = PageId{8};
+  cipher.Encrypt(second, 5);
+
+  EXPECT_EQ(PageCipher::WrittenBy(first), PageCipher::WrittenBy(second));
+  EXPECT_NE(PageCipher::IvOf(first), PageCipher::IvOf(second));
+  cipher.Decrypt(second, second);
+  EXPECT_EQ(AsString(reinterpret_cast<const Page*>(second.data())
+                         ->GetLeafElement(0)
+                         .Key()),
+            "other");
+}
+
+TEST(PageCipherTest, RequiresFullKey) {
+  EXPECT_THROW(PageCipher(Key(16, 1)), std::system_error);
+}
+
+TEST(PageCipherTest, DetectsTampering) {
+  const PageCipher cipher(Key(32, 1));
+  auto run = LeafRun(PageId{9}, 1024);
+  cipher.Encrypt(run, 3);
+
+  const auto expect_failure = [&](std::vector<std::byte> bad) {
+    try {
+      cipher.Decrypt(bad, bad);
+      FAIL() << "tampered page decrypted";
+    } catch (const std::system_error& e) {
+      EXPECT_EQ(e.code(), Errc::kDecryptionFailed);
+    }
+  };
+
+  auto body = run;
+  body[100] ^= std::byte{0x01};
+  expect_failure(body);
+
+  // The header is authenticated too: a page replayed under another id.
+  auto moved = run;
+  reinterpret_cast<Page*>(moved.data())->id = PageId{10};
+  expect_failure(moved);
+
+  auto txid = run;
+  txid[txid.size() - PageCipher::kOverhead] ^= std::byte{0x01};
+  expect_failure(txid);
+
+  EXPECT_THROW(PageCipher(Key(32, 2)).Decrypt(run, run), std::system_error);
+}
+
+}  // namespace boltdb
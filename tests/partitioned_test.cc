@@ -0,0 +1,179 @@
+#include "partitioned.hh"
+
+#include <gtest/gtest.h>
+
+#include <array>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "file.hh"
+#include "node.hh"
+
+namespace boltdb {
+
+std::array<std::byte, 9> TimeKey(std::uint64_t t, char suffix) {
+  std::array<std::byte, 9> key{};
+  StoreBigEndian64(key.data(), t);
+  key[8] = static_cast<std::byte>(suffix);
+  return key;
+}
+
+/// One partition: a file on disk and an in-memory single-leaf bucket.
+struct FakeDB {
+  explicit FakeDB(const std::filesystem::path& path)
+      : file(path, O_RDWR | O_CREAT) {}
+
+  void Put(std::span<const std::byte> key) {
+    leaf.Put(key, key, {}, PageId{0}, LeafFlag::kNone);
+  }
+
+  Cursor NewCursor() {
+    page = std::make_unique<std::byte[]>(leaf.Size());
+    leaf.Write(*reinterpret_cast<Page*>(page.get()));
+    return Cursor(
+        [this](PageId) { return reinterpret_cast<const Page*>(page.get()); },
+        PageId{0});
+  }
+
+  File file;
+  Node leaf{true};
+  std::unique_ptr<std::byte[]> page;
+};
+
+class PartitionedDBTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+    dir_ = std::filesystem::temp_directory_path() /
+           (std::string("boltdb_partitioned_") + info->name());
+    std::filesystem::remove_all(dir_);
+  }
+
+  void TearDown() override { std::filesystem::remove_all(dir_); }
+
+  PartitionedDB<FakeDB> Open() {
+    return PartitionedDB<FakeDB>(
+        dir_,
+        [this](const std::filesystem::path& path, std::uint64_t) {
+          ++opened_;
+          auto db = std::make_shared<FakeDB>(path);
+          live_.push_back(db);
+          return db;
+        },
+        TimePartitionOptions{.period = 100});
+  }
+
+  std::filesystem::path dir_;
+  int opened_ = 0;
+  std::vector<std::weak_ptr<FakeDB>> live_;
+};
+
+TEST_F(PartitionedDBTest, RoutesByTime) {
+  auto db = Open();
+  for (std::uint64_t t : {5, 99, 100, 250, 260}) {
+    db.For(TimeKey(t, 'a'))->Put(TimeKey(t, 'a'));
+  }
+
+  EXPECT_EQ(db.Partitions(), (std::vector<std::uint64_t>{0, 100, 200}));
+  EXPECT_EQ(opened_, 3);
+  EXPECT_EQ(db.For(TimeKey(42, 'x'))->leaf.Count(), 2);
+  EXPECT_TRUE(std::filesystem::exists(dir_ / "00000000000000000200.db"));
+
+  // Partitions on disk are found again and opened lazily.
+  auto reopened = Open();
+  EXPECT_EQ(reopened.Partitions(), db.Partitions());
+  EXPECT_EQ(opened_, 3);
+}
+
+TEST_F(PartitionedDBTest, SkipsStrayFiles) {
+  std::filesystem::create_directories(dir_);
+  for (const auto* name : {"notes.db", "12x.db", "00000000000000000300.db"}) {
+    File(dir_ / name, O_RDWR | O_CREAT);
+  }
+
+  auto db = Open();
+  EXPECT_EQ(db.Partitions(), std::vector<std::uint64_t>{300});
+}
+
+TEST_F(PartitionedDBTest, ShortKey) {
+  auto db = Open();
+  const std::array<std::byte, 7> key{};
+
+  try {
+    db.For(key);
+    FAIL() << "expected a key without a time prefix to be rejected";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code(), Errc::kKeyRequired);
+  }
+  EXPECT_TRUE(db.Partitions().empty());
+}
+
+TEST_F(PartitionedDBTest, CursorAcrossPartitions) {
+  auto db = Open();
+  for (std::uint64_t t : {250, 5, 150, 120, 60, 310}) {
+    db.For(TimeKey(t, 'k'))->Put(TimeKey(t, 'k'));
+  }
+
+  auto c = db.NewCursor(50, 300, [](FakeDB& p) { return p.NewCursor(); });
+  std::vector<std::uint64_t> times;
+  for (auto kv = c.First(); kv; kv = c.Next()) {
+    times.push_back(LoadBigEndian64(kv->key.data()));
+  }
+
+  // Partitions 0, 100 and 200 overlap [50, 300); 300 does not.
+  EXPECT_EQ(times, (std::vector<std::uint64_t>{5, 60, 120, 150, 250}));
+}
+
+TEST_F(PartitionedDBTest, DropBefore) {
+  auto db = Open();
+  std::shared_ptr<FakeDB> held;
+  for (std::uint64_t t : {10, 110, 210}) {
+    held = db.For(TimeKey(t, 'a'));
+    held->Put(TimeKey(t, 'a'));
+  }
+  held = db.Open(0);
+
+  // Partition 100 ends at 200, which is not before 199.
+  EXPECT_EQ(db.DropBefore(199), 1);
+  EXPECT_EQ(db.DropBefore(200), 1);
+  EXPECT_EQ(db.Partitions(), std::vector<std::uint64_t>{200});
+  EXPECT_FALSE(std::filesystem::exists(dir_ / "00000000000000000000.db"));
+  EXPECT_FALSE(std::filesystem::exists(dir_ / "00000000000000000100.db"));
+
+  // A handle taken before the drop still works.
+  EXPECT_EQ(held->leaf.Count(), 1);
+}
+
+TEST_F(PartitionedDBTest, DropWhileCursorOpen) {
+  auto db = Open();
+  for (std::uint64_t t : {10, 110, 210}) {
+    db.For(TimeKey(t, 'a'))->Put(TimeKey(t, 'a'));
+  }
+
+  {
+    auto c = db.NewCursor(0, 300, [](FakeDB& p) { return p.NewCursor(); });
+    ASSERT_TRUE(c.First());
+
+    // The cursor keeps the dropped partitions open until it goes.
+    EXPECT_EQ(db.DropBefore(200), 2);
+    EXPECT_FALSE(live_[0].expired());
+    std::vector<std::uint64_t> times;
+    for (auto kv = c.Next(); kv; kv = c.Next()) {
+      times.push_back(LoadBigEndian64(kv->key.data()));
+    }
+    EXPECT_EQ(times, (std::vector<std::uint64_t>{110, 210}));
+  }
+  EXPECT_TRUE(live_[0].expired());
+  EXPECT_TRUE(live_[1].expired());
+
+  // Dropped periods are not opened again by a later cursor.
+  auto c = db.NewCursor(0, 300, [](FakeDB& p) { return p.NewCursor(); });
+  EXPECT_EQ(opened_, 3);
+  EXPECT_EQ(db.Partitions(), std::vector<std::uint64_t>{200});
+  EXPECT_FALSE(std::filesystem::exists(dir_ / "00000000000000000000.db"));
+}
+
+}  // namespace boltdb
@@ -0,0 +1,108 @@
+#include "rebalance.hh"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace boltdb {
+
+using namespace std::chrono_literals;
+
+PageIds ToPageIds(const std::vector<uint64_t>& ids) {
+  PageIds pgids;
+  for (auto id : ids) pgids.push_back(PageId{id});
+  return pgids;
+}
+
+TEST(RebalanceQueueTest, TakeSortedAndDeduplicated) {
+  RebalanceQueue queue;
+  queue.Record(ToPageIds({9, 3, 7}));
+  queue.Record(ToPageIds({3, 5}));
+  EXPECT_EQ(queue.Size(), 4);
+
+  EXPECT_EQ(queue.Take(3), ToPageIds({3, 5, 7}));
+  EXPECT_EQ(queue.Take(3), ToPageIds({9}));
+  EXPECT_TRUE(queue.Empty());
+}
+
+TEST(RebalanceQueueTest, Forget) {
+  RebalanceQueue queue;
+  queue.Record(ToPageIds({1, 2, 3}));
+  queue.Forget(ToPageIds({2, 4}));
+
+  EXPECT_EQ(queue.Take(10), ToPageIds({1, 3}));
+}
+
+TEST(RebalanceQueueTest, RequeueSkipsForgotten) {
+  RebalanceQueue queue;
+  queue.Record(ToPageIds({1, 2, 3}));
+
+  // Page 2 is freed while its batch is being merged.
+  const auto batch = queue.Take(10);
+  queue.Forget(ToPageIds({2}));
+  queue.Requeue(batch);
+  EXPECT_EQ(queue.Take(10), ToPageIds({1, 3}));
+}
+
+TEST(DeferredRebalancerTest, MergesInBatches) {
+  std::mutex mu;
+  std::vector<PageIds> batches;
+  std::atomic<std::size_t> merged{0};
+
+  DeferredRebalancer rebalancer(
+      [&](std::span<const PageId> ids) {
+        std::lock_guard lock(mu);
+        batches.emplace_back(ids.begin(), ids.end());
+        merged += ids.size();
+        return true;
+      },
+      RebalanceOptions{.batch_size = 2, .interval = 10ms});
+
+  rebalancer.Record(ToPageIds({5, 1, 4, 2, 3}));
+
+  for (int i = 0; i < 200 && merged < 5; ++i) std::this_thread::sleep_for(5ms);
+
+  std::lock_guard lock(mu);
+  EXPECT_EQ(merged, 5);
+  EXPECT_EQ(rebalancer.Pending(), 0);
+  for (const auto& batch : batches) EXPECT_LE(batch.size(), 2);
+}
+
+TEST(DeferredRebalancerTest, RequeuesWhenWriterBusy) {
+  std::atomic<bool> busy{true};
+  std::atomic<int> attempts{0};
+  std::atomic<std::size_t> merged{0};
+
+  DeferredRebalancer rebalancer(
+      [&](std::span<const PageId> ids) {
+        ++attempts;
+        if (busy) return false;
+        merged += ids.size();
+        return true;
+      },
+      RebalanceOptions{.batch_size = 8, .interval = 10ms});
+
+  rebalancer.Record(ToPageIds({1, 2, 3}));
+
+  // The batch is out of the queue while a merge runs, so wait for it to be
+  // put back rather than for the attempt, and check what was seen then.
+  bool requeued = false;
+  for (int i = 0; i < 200 && !requeued; ++i) {
+    requeued = attempts > 0 && rebalancer.Pending() == 3;
+    if (!requeued) std::this_thread::sleep_for(5ms);
+  }
+  EXPECT_TRUE(requeued);
+  EXPECT_EQ(merged, 0);
+
+  busy = false;
+  rebalancer.NotifyWriterIdle();
+  for (int i = 0; i < 200 && merged < 3; ++i) std::this_thread::sleep_for(5ms);
+  EXPECT_EQ(merged, 3);
+  EXPECT_EQ(rebalancer.Pending(), 0);
+}
+
+}  // namespace boltdb
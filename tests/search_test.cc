@@ -0,0 +1,128 @@
+#include "search.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "node.hh"
+
+namespace boltdb {
+
+using Key16 = std::array<std::byte, 16>;
+
+class SearchTest : public ::testing::Test {
+ protected:
+  /// Writes `keys` as a leaf page and a branch page.
+  void Build(std::vector<Key16> keys) {
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+    keys_ = keys;
+
+    Node leaf(true);
+    Node branch(false);
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      leaf.Put(keys[i], keys[i], {}, PageId{0}, LeafFlag::kNone);
+      branch.Put(keys[i], keys[i], {}, PageId{i + 100}, LeafFlag::kNone);
+    }
+    leaf_buf_ = Write(leaf);
+    branch_buf_ = Write(branch);
+  }
+
+  std::span<const LeafElement> Leaf() const {
+    return reinterpret_cast<const Page*>(leaf_buf_.get())->LeafElements();
+  }
+
+  std::span<const BranchElement> Branch() const {
+    return reinterpret_cast<const Page*>(branch_buf_.get())->BranchElements();
+  }
+
+  static std::unique_ptr<std::byte[]> Write(const Node& n) {
+    auto buf = std::make_unique<std::byte[]>(n.Size());
+    n.Write(*reinterpret_cast<Page*>(buf.get()));
+    return buf;
+  }
+
+  std::vector<Key16> keys_;
+  std::unique_ptr<std::byte[]> leaf_buf_;
+  std::unique_ptr<std::byte[]> branch_buf_;
+};
+
+Key16 RandomKey(std::mt19937_64& gen) {
+  Key16 key;
+  for (auto& b : key) b = static_cast<std::byte>(gen());
+  return key;
+}
+
+TEST_F(SearchTest, InterpolationMatchesBinary) {
+  std::mt19937_64 gen(3);
+  std::vector<Key16> keys;
+  for (int i = 0; i < 256; ++i) keys.push_back(RandomKey(gen));
+  Build(keys);
+
+  auto targets = keys_;
+  for (int i = 0; i < 1000; ++i) targets.push_back(RandomKey(gen));
+  targets.push_back(Key16{});
+  Key16 max;
+  max.fill(std::byte{0xFF});
+  targets.push_back(max);
+
+  for (const auto& t : targets) {
+    ASSERT_EQ(SearchLeaf(Leaf(), t, KeySearch::kInterpolation),
+              SearchLeaf(Leaf(), t, KeySearch::kBinary));
+    ASSERT_EQ(SearchBranch(Branch(), t, KeySearch::kInterpolation),
+              SearchBranch(Branch(), t, KeySearch::kBinary));
+  }
+}
+
+TEST_F(SearchTest, SkewedKeysStillCorrect) {
+  // Clustered keys defeat interpolation; the binary fallback must keep
+  // results correct.
+  std::vector<Key16> keys;
+  for (int i = 0; i < 200; ++i) {
+    Key16 key{};
+    key[15] = static_cast<std::byte>(i);
+    keys.push_back(key);
+  }
+  Key16 far{};
+  far[0] = std::byte{0xF0};
+  keys.push_back(far);
+  Build(keys);
+
+  for (const auto& t : keys_) {
+    ASSERT_EQ(SearchLeaf(Leaf(), t, KeySearch::kInterpolation),
+              SearchLeaf(Leaf(), t, KeySearch::kBinary));
+  }
+}
+
+TEST_F(SearchTest, UniformKeysTakeFewProbes) {
+  std::mt19937_64 gen(5);
+  std::vector<Key16> keys;
+  for (int i = 0; i < 256; ++i) keys.push_back(RandomKey(gen));
+  Build(keys);
+
+  std::size_t interpolation = 0;
+  std::size_t binary = 0;
+  for (const auto& t : keys_) {
+    const auto pred = [&](const LeafElement& e) {
+      return CompareKeys(e.Key(), t) < 0;
+    };
+    InterpolationPartitionPoint(Leaf(), t, [&](const LeafElement& e) {
+      ++interpolation;
+      return pred(e);
+    });
+    std::partition_point(Leaf().begin(), Leaf().end(),
+                         [&](const LeafElement& e) {
+                           ++binary;
+                           return pred(e);
+                         });
+  }
+
+  EXPECT_LT(interpolation, binary);
+}
+
+}  // namespace boltdb
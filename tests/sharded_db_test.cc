@@ -0,0 +1,205 @@
+#include "sharded_db.hh"
+
+#include <gtest/gtest.h>
+
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "test_util.hh"
+
+namespace boltdb {
+
+std::vector<std::byte> ToVector(std::string_view s) {
+  const auto b = AsBytes(s);
+  return {b.begin(), b.end()};
+}
+
+enum class TxState { kPrepared, kCommitted, kAborted };
+
+/// Records the state of each transaction; the state survives "crashes"
+/// because the test keeps it outside the participant.
+struct ShardLog {
+  std::mutex mu;
+  std::map<GlobalTxId, TxState> states;
+  bool vote = true;
+  bool fail = false;
+};
+
+class FakeShard : public ShardParticipant {
+ public:
+  explicit FakeShard(ShardLog& log) : log_(log) {}
+
+  bool Prepare(GlobalTxId gtid) override {
+    std::lock_guard lock(log_.mu);
+    if (log_.fail) throw std::runtime_error("prepare failed");
+    log_.states[gtid] = TxState::kPrepared;
+    return log_.vote;
+  }
+  void Commit(GlobalTxId gtid) override { Set(gtid, TxState::kCommitted); }
+  void Abort(GlobalTxId gtid) override { Set(gtid, TxState::kAborted); }
+
+  std::vector<GlobalTxId> InDoubt() override {
+    std::lock_guard lock(log_.mu);
+    std::vector<GlobalTxId> out;
+    for (const auto& [gtid, state] : log_.states) {
+      if (state == TxState::kPrepared) out.push_back(gtid);
+    }
+    return out;
+  }
+
+ private:
+  void Set(GlobalTxId gtid, TxState state) {
+    std::lock_guard lock(log_.mu);
+    log_.states[gtid] = state;
+  }
+
+  ShardLog& log_;
+};
+
+class ShardedDBTest : public ::testing::Test {
+ protected:
+  void SetUp() override {
+    const auto* info = ::testing::UnitTest::GetInstance()->current_test_info();
+    path_ = std::filesystem::temp_directory_path() /
+            (std::string("boltdb_coordinator_") + info->name());
+    std::filesystem::remove(path_);
+  }
+
+  void TearDown() override { std::filesystem::remove(path_); }
+
+  std::unique_ptr<ShardedDB> Open(std::size_t checkpoint_every = 1024) {
+    std::vector<std::unique_ptr<ShardParticipant>> shards;
+    for (auto& log : logs_) shards.push_back(std::make_unique<FakeShard>(log));
+    return std::make_unique<ShardedDB>(ShardRouter::ByHash(3),
+                                       std::move(shards), path_,
+                                       checkpoint_every);
+  }
+
+  std::filesystem::path path_;
+  ShardLog logs_[3];
+};
+
+TEST(ShardRouterTest, ByRange) {
+  const auto router = ShardRouter::ByRange({ToVector("g"), ToVector("p")});
+  EXPECT_EQ(router.Shards(), 3);
+  EXPECT_EQ(router.ShardOf(AsBytes("apple")), 0);
+  EXPECT_EQ(router.ShardOf(AsBytes("g")), 1);
+  EXPECT_EQ(router.ShardOf(AsBytes("kiwi")), 1);
+  EXPECT_EQ(router.ShardOf(AsBytes("pear")), 2);
+}
+
+TEST(ShardRouterTest, ByHash) {
+  const auto router = ShardRouter::ByHash(4);
+  std::vector<int> counts(4);
+  for (int i = 0; i < 1000; ++i) {
+    const auto key = std::to_string(i);
+    const auto shard = router.ShardOf(AsBytes(key));
+    ASSERT_LT(shard, 4);
+    EXPECT_EQ(shard, router.ShardOf(AsBytes(key)));
+    ++counts[shard];
+  }
+  for (const auto c : counts) EXPECT_GT(c, 150);
+}
+
+TEST_F(ShardedDBTest, CommitAcrossShards) {
+  auto db = Open();
+  const auto gtid = db->Begin();
+  const std::vector<std::size_t> touched = {0, 2, 0};
+
+  EXPECT_TRUE(db->Commit(gtid, touched));
+  EXPECT_EQ(logs_[0].states[gtid], TxState::kCommitted);
+  EXPECT_EQ(logs_[2].states[gtid], TxState::kCommitted);
+  EXPECT_FALSE(logs_[1].states.contains(gtid));
+  EXPECT_GT(std::filesystem::file_size(path_), 0);
+}
+
+TEST_F(ShardedDBTest, SingleShardSkipsLog) {
+  auto db = Open();
+  const auto gtid = db->Begin();
+  const std::vector<std::size_t> touched = {1};
+
+  EXPECT_TRUE(db->Commit(gtid, touched));
+  EXPECT_EQ(logs_[1].states[gtid], TxState::kCommitted);
+  EXPECT_EQ(std::filesystem::file_size(path_), 0);
+}
+
+TEST_F(ShardedDBTest, NoVoteAbortsEverywhere) {
+  auto db = Open();
+  logs_[1].vote = false;
+  const auto gtid = db->Begin();
+  const std::vector<std::size_t> touched = {0, 1, 2};
+
+  EXPECT_FALSE(db->Commit(gtid, touched));
+  for (auto& log : logs_) EXPECT_EQ(log.states[gtid], TxState::kAborted);
+}
+
+TEST_F(ShardedDBTest, FailedPrepareAbortsEverywhere) {
+  auto db = Open();
+  logs_[2].fail = true;
+  const auto gtid = db->Begin();
+  const std::vector<std::size_t> touched = {0, 1, 2};
+
+  EXPECT_THROW(db->Commit(gtid, touched), std::runtime_error);
+  EXPECT_EQ(logs_[0].states[gtid], TxState::kAborted);
+  EXPECT_EQ(logs_[1].states[gtid], TxState::kAborted);
+  EXPECT_EQ(std::filesystem::file_size(path_), 0);
+}
+
+TEST_F(ShardedDBTest, CheckpointsAppliedDecisions) {
+  const std::vector<std::size_t> touched = {0, 1};
+  GlobalTxId last = 0;
+  {
+    auto db = Open(/*checkpoint_every=*/4);
+    for (int i = 0; i < 20; ++i) {
+      last = db->Begin();
+      ASSERT_TRUE(db->Commit(last, touched));
+
+      // Applied decisions are dropped, so the log stays short.
+      EXPECT_LT(std::filesystem::file_size(path_), 4 * 24);
+    }
+  }
+  EXPECT_FALSE(std::filesystem::exists(path_.string() + ".tmp"));
+
+  // The watermark keeps ids increasing after a restart.
+  auto reopened = Open(4);
+  EXPECT_GT(reopened->Begin(), last);
+}
+
+TEST_F(ShardedDBTest, RecoverResolvesInDoubt) {
+  GlobalTxId committed = 0;
+  GlobalTxId undecided = 0;
+  {
+    auto db = Open();
+    committed = db->Begin();
+    undecided = db->Begin();
+  }
+
+  // Crash after the decision for `committed` was logged but before shard 1
+  // applied it, and before any decision for `undecided`.
+  {
+    CoordinatorLog log(path_);
+    log.LogCommit(committed);
+  }
+  logs_[0].states[committed] = TxState::kCommitted;
+  logs_[1].states[committed] = TxState::kPrepared;
+  logs_[0].states[undecided] = TxState::kPrepared;
+  logs_[2].states[undecided] = TxState::kPrepared;
+
+  auto db = Open();
+  db->Recover();
+  EXPECT_EQ(logs_[1].states[committed], TxState::kCommitted);
+  EXPECT_EQ(logs_[0].states[undecided], TxState::kAborted);
+  EXPECT_EQ(logs_[2].states[undecided], TxState::kAborted);
+
+  // Ids keep increasing after the log was reset.
+  EXPECT_GT(db->Begin(), undecided);
+  auto reopened = Open();
+  EXPECT_GT(reopened->Begin(), committed);
+}
+
+}  // namespace boltdb
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+#include <string_view>
+
+namespace boltdb {
+
+/// Views a string as the bytes boltdb takes keys and values as.
+inline std::span<const std::byte> AsBytes(std::string_view s) {
+  return {reinterpret_cast<const std::byte*>(s.data()), s.size()};
+}
+
+/// Views bytes as a string, e.g. to compare a key or value in a test.
+inline std::string_view AsString(std::span<const std::byte> b) {
+  return {reinterpret_cast<const char*>(b.data()), b.size()};
+}
+
+}  // namespace boltdb
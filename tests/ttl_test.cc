@@ -0,0 +1,94 @@
+#include "ttl.hh"
+
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <chrono>
+#include <format>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "test_util.hh"
+
+namespace boltdb {
+
+TtlClock::time_point At(int seconds) {
+  return TtlClock::time_point(std::chrono::seconds(seconds));
+}
+
+TEST(TtlTest, SetAndClearExpiry) {
+  Node data(true);
+  Node ttl(true);
+  PutWithTtl(data, ttl, AsBytes("k"), AsBytes("v"), At(100));
+
+  EXPECT_EQ(ExpiryOf(ttl, AsBytes("k")), At(100));
+  EXPECT_FALSE(IsExpired(ttl, AsBytes("k"), At(99)));
+  EXPECT_TRUE(IsExpired(ttl, AsBytes("k"), At(100)));
+
+  // Moving the expiry replaces the index entry.
+  SetExpiry(ttl, AsBytes("k"), At(200));
+  EXPECT_EQ(ExpiryOf(ttl, AsBytes("k")), At(200));
+  EXPECT_EQ(ttl.Count(), 2);
+
+  SetExpiry(ttl, AsBytes("k"), std::nullopt);
+  EXPECT_FALSE(ExpiryOf(ttl, AsBytes("k")).has_value());
+  EXPECT_EQ(ttl.Count(), 0);
+  EXPECT_EQ(data.Count(), 1);
+}
+
+TEST(TtlTest, ReapExpired) {
+  Node data(true);
+  Node ttl(true);
+  data.Put(AsBytes("keep"), AsBytes("keep"), AsBytes("v"), PageId{0},
+           LeafFlag::kNone);
+  // Expiry order differs from key order.
+  for (int i = 0; i < 10; ++i) {
+    const auto key = std::format("k{}", 9 - i);
+    PutWithTtl(data, ttl, AsBytes(key), AsBytes("v"), At(10 + i));
+  }
+
+  // Due at 14: k9..k5. A limit of 3 takes the three oldest.
+  EXPECT_EQ(ReapExpired(data, ttl, At(14), 3), 3);
+  EXPECT_EQ(data.Count(), 8);
+  EXPECT_FALSE(ExpiryOf(ttl, AsBytes("k9")).has_value());
+  EXPECT_TRUE(ExpiryOf(ttl, AsBytes("k6")).has_value());
+
+  EXPECT_EQ(ReapExpired(data, ttl, At(14), 100), 2);
+  EXPECT_EQ(ReapExpired(data, ttl, At(14), 100), 0);
+
+  const auto& inodes = data.GetInodes();
+  ASSERT_EQ(inodes.size(), 6);
+  EXPECT_EQ(AsString(inodes[0].Key()), "k0");
+  EXPECT_EQ(AsString(inodes[4].Key()), "k4");
+  EXPECT_EQ(AsString(inodes[5].Key()), "keep");
+  EXPECT_EQ(ttl.Count(), 10);
+
+  EXPECT_EQ(ReapExpired(data, ttl, At(1000), 100), 5);
+  EXPECT_EQ(data.Count(), 1);
+  EXPECT_EQ(ttl.Count(), 0);
+}
+
+TEST(TtlTest, ReaperDrainsBacklog) {
+  std::atomic<int> backlog = 10;
+  std::atomic<int> calls = 0;
+  TtlReaper reaper(
+      [&](std::size_t limit) {
+        ++calls;
+        const auto n = std::min<int>(backlog, static_cast<int>(limit));
+        backlog -= n;
+        return static_cast<std::size_t>(n);
+      },
+      TtlReaperOptions{.batch_size = 4, .interval = std::chrono::hours(1)});
+
+  reaper.Wake();
+  for (int i = 0; i < 200 && backlog > 0; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+
+  // 4 + 4 + 2: the short batch puts the reaper back to sleep.
+  EXPECT_EQ(backlog, 0);
+  EXPECT_EQ(calls, 3);
+}
+
+}  // namespace boltdb
@@ -0,0 +1,102 @@
+#include "value_stream.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#include "test_util.hh"
+
+namespace boltdb {
+
+std::string Pattern(std::size_t n) {
+  std::string s(n, '\0');
+  for (std::size_t i = 0; i < n; ++i) s[i] = static_cast<char>('a' + i % 26);
+  return s;
+}
+
+TEST(ValueStreamTest, WriteInChunks) {
+  const auto value = Pattern(10000);
+
+  Node n(true);
+  ValueWriter w(n, AsBytes("blob"), value.size());
+  for (std::size_t i = 0; i < value.size(); i += 777) {
+    w.Write(AsBytes(std::string_view(value).substr(i, 777)));
+  }
+  EXPECT_EQ(w.Remaining(), 0);
+  EXPECT_EQ(n.Count(), 0);
+
+  w.Commit();
+  ASSERT_EQ(n.Count(), 1);
+  EXPECT_EQ(AsString(n.GetInodes()[0].Key()), "blob");
+  EXPECT_EQ(AsString(n.GetInodes()[0].Value()), value);
+}
+
+TEST(ValueStreamTest, SizeMismatch) {
+  Node n(true);
+  ValueWriter w(n, AsBytes("k"), 4);
+  w.Write(AsBytes("abc"));
+
+  try {
+    w.Commit();
+    FAIL() << "short value committed";
+  } catch (const std::system_error& e) {
+    EXPECT_EQ(e.code(), Errc::kValueSizeMismatch);
+  }
+  EXPECT_THROW(w.Write(AsBytes("de")), std::system_error);
+  EXPECT_EQ(n.Count(), 0);
+
+  EXPECT_THROW(ValueWriter(n, {}, 1), std::system_error);
+  EXPECT_THROW(ValueWriter(n, AsBytes("k"), kMaxValueSize + 1),
+               std::system_error);
+}
+
+TEST(ValueStreamTest, MovedFromWriterIsEmpty) {
+  Node n(true);
+  ValueWriter w(n, AsBytes("k"), 3);
+  w.Write(AsBytes("abc"));
+
+  ValueWriter moved(std::move(w));
+  EXPECT_EQ(w.Remaining(), 0);
+  EXPECT_EQ(moved.Remaining(), 0);
+  moved.Commit();
+  ASSERT_EQ(n.Count(), 1);
+  EXPECT_EQ(AsString(n.GetInodes()[0].Value()), "abc");
+}
+
+TEST(ValueStreamTest, ReadChunksPerPage) {
+  constexpr std::size_t kPageSize = 4096;
+  const auto value = Pattern(3 * kPageSize);
+
+  Node n(true);
+  n.Put(AsBytes("a"), AsBytes("a"), AsBytes("x"), PageId{0}, LeafFlag::kNone);
+  ValueWriter w(n, AsBytes("b"), value.size());
+  w.Write(AsBytes(value));
+  w.Commit();
+
+  const auto pages = (n.Size() + kPageSize - 1) / kPageSize;
+  auto buf = std::make_unique<std::byte[]>(pages * kPageSize);
+  std::memset(buf.get(), 0, pages * kPageSize);
+  auto* p = reinterpret_cast<Page*>(buf.get());
+  n.Write(*p);
+
+  ValueChunks chunks(*p, 1, kPageSize);
+  std::string read;
+  std::size_t count = 0;
+  while (auto chunk = chunks.Next()) {
+    // Every chunk lies within a single page of the run.
+    const auto begin = static_cast<std::size_t>(chunk->data() - buf.get());
+    EXPECT_EQ(begin / kPageSize, (begin + chunk->size() - 1) / kPageSize);
+    read += AsString(*chunk);
+    ++count;
+  }
+  EXPECT_EQ(read, value);
+  EXPECT_EQ(count, 4);
+  EXPECT_EQ(chunks.Remaining(), 0);
+}
+
+}  // namespace boltdb